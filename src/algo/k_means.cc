@@ -21,279 +21,648 @@ Repeat
 
 #include "./k_means.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <limits>
 #include <vector>
 
-void K_Means::AssignPointsToClusters() {
-  // clear points from previous iteration
-  for (size_t i = 0; i < clusters_.size(); i++) {
-    clusters_[i].points_.clear();
-    clusters_[i].worst_distance_ = 0.0;
-    clusters_[i].pos_of_worst_point_ = -1;
+double K_Means::AssignPointsToClusters(RunState& state, ThreadPool* pool) {
+  if (state.centroids_.Rows() != static_cast<size_t>(num_of_clusters_)) {
+    state.centroids_.Resize(num_of_clusters_, points_->Cols());
   }
 
-  squared_norms_points_.clear();
-  for (size_t i = 0; i < points_.size(); i++) {
-    squared_norms_points_.push_back(CalculateSquaredNorm(points_[i]));
+  state.squared_norms_centroids_.clear();
+  for (size_t i = 0; i < state.clusters_.size(); i++) {
+    const std::vector<double>& centroid = state.clusters_[i].centroid_;
+    std::copy(centroid.begin(), centroid.end(), state.centroids_.Row(i));
+    state.squared_norms_centroids_.push_back(state.clusters_[i].squared_norm_);
   }
 
-  squared_norms_centroids_.clear();
-  for (size_t i = 0; i < clusters_.size(); i++) {
-    squared_norms_centroids_.push_back(
-        CalculateSquaredNorm(clusters_[i].centroid_));
+  if (UsesFloat()) {
+    PrepareFloatCentroids(state);
+  } else if (UsesCentroidTree() && state.bounds_valid_) {
+    state.centroid_tree_.Build(state.centroids_);
+  } else if (!UsesBounds() && algorithm_ != Algorithm::FILTERING &&
+             num_of_clusters_ >= BLOCKED_ASSIGN_MIN_K) {
+    PackCentroids(state.centroids_, state.squared_norms_centroids_.data(),
+                  state.packed_centroids_);
   }
 
-  // assign points to clusters O(n*k*d)
-  for (size_t i = 0; i < num_of_points_; i++) {
-    double lowest_distance = std::numeric_limits<double>::max();
+  long long centroid_distances = 0;
+  if (UsesBounds()) {
+    UpdateCentroidBounds(state);
+    centroid_distances = static_cast<long long>(num_of_clusters_) *
+                         (num_of_clusters_ + 1) / 2;
+  }
 
-    int centroid = 0;
-    std::vector<double>& curr_point = points_[i];
+  auto assign_range = [this, &state](size_t begin, size_t end,
+                                     PartialSums& partial) {
+    if (algorithm_ == Algorithm::HAMERLY)
+      AssignPointsInRangeHamerly(state, begin, end, partial);
+    else if (algorithm_ == Algorithm::ELKAN)
+      AssignPointsInRangeElkan(state, begin, end, partial);
+    else if (algorithm_ == Algorithm::YINYANG)
+      AssignPointsInRangeYinyang(state, begin, end, partial);
+    else
+      AssignPointsInRange(state, begin, end, partial);
+  };
+
+  // assign points to clusters O(n*k*d / threads), the ball tree groups
+  // points by their previous label so the first pass scans every centroid
+  if (algorithm_ == Algorithm::FILTERING) {
+    FilterPoints(state, pool);
+  } else if (UsesCentroidTree() && state.bounds_valid_) {
+    AssignPointsBallTree(state, pool);
+  } else if (pool != nullptr) {
+    pool->ParallelFor(num_of_points_,
+                      [&state, &assign_range](size_t begin, size_t end,
+                                              int worker) {
+                        assign_range(begin, end, state.partial_sums_[worker]);
+                      });
+  } else {
+    assign_range(0, num_of_points_, state.partial_sums_[0]);
+  }
+  state.bounds_valid_ = true;
+
+  ReducePartialSums(state);
+  if (algorithm_ == Algorithm::FILTERING) RefreshWorstDistances(state);
+
+  double sse = 0.0;
+  state.num_of_distance_evaluations_ += centroid_distances;
+  state.points_moved_ = 0;
+  for (size_t i = 0; i < state.partial_sums_.size(); i++) {
+    sse += state.partial_sums_[i].sse_;
+    state.num_of_distance_evaluations_ +=
+        state.partial_sums_[i].num_of_distances_;
+    state.points_moved_ += state.partial_sums_[i].points_moved_;
+  }
+  return sse;
+}
+
+void K_Means::PrepareFloatCentroids(RunState& state) {
+  const FloatKernels& kernels = GetKernels<float>();
+  size_t stride = float_points_->Stride();
+
+  if (state.float_centroids_.Rows() != static_cast<size_t>(num_of_clusters_)) {
+    state.float_centroids_.Resize(num_of_clusters_, points_->Cols());
+  }
+  state.float_norms_centroids_.resize(num_of_clusters_);
+  for (int c = 0; c < num_of_clusters_; c++) {
+    const std::vector<double>& centroid = state.clusters_[c].centroid_;
+    float* row = state.float_centroids_.Row(c);
+    std::copy(centroid.begin(), centroid.end(), row);
+    state.float_norms_centroids_[c] = kernels.dot_product_(row, row, stride);
+  }
+
+  if (num_of_clusters_ >= BLOCKED_ASSIGN_MIN_K) {
+    PackCentroids(state.float_centroids_, state.float_norms_centroids_.data(),
+                  state.packed_float_centroids_);
+  }
+}
+
+void K_Means::AssignPointsInRange(RunState& state, size_t begin, size_t end,
+                                  PartialSums& partial) {
+  if (UsesFloat()) {
+    AssignPointsInRange(*float_points_, *float_squared_norms_points_,
+                        state.float_centroids_, state.float_norms_centroids_,
+                        state.packed_float_centroids_, state.labels_, begin,
+                        end, partial);
+  } else {
+    AssignPointsInRange(*points_, *squared_norms_points_,
+                        state.centroids_, state.squared_norms_centroids_,
+                        state.packed_centroids_, state.labels_, begin, end,
+                        partial);
+  }
+}
 
-    // check distance between each point and each cluster
-    for (size_t j = 0; j < num_of_clusters_; j++) {
-      double new_distance = GetDistanceSquaredNorms(
-          squared_norms_points_[i], squared_norms_centroids_[j],
-          std::inner_product(curr_point.begin(), curr_point.end(),
-                             clusters_[j].centroid_.begin(), 0.0));
-      if (new_distance < lowest_distance) {
-        lowest_distance = new_distance;
-        centroid = j;
+template <typename T>
+void K_Means::AssignPointsInRange(const BasicMatrix<T>& points,
+                                  const std::vector<T>& point_norms,
+                                  const BasicMatrix<T>& centroids,
+                                  const std::vector<T>& centroid_norms,
+                                  const BasicPackedCentroids<T>& packed,
+                                  std::vector<int>& labels, size_t begin,
+                                  size_t end, PartialSums& partial) {
+  size_t stride = points.Stride();
+  const BasicKernels<T>& kernels = GetKernels<T>();
+
+  ResetPartialSums(partial);
+  partial.num_of_distances_ =
+      static_cast<long long>(end - begin) * num_of_clusters_;
+
+  // for larger k the dot products are done as a blocked matrix product
+  if (num_of_clusters_ >= BLOCKED_ASSIGN_MIN_K) {
+    double distances[kAssignBlockRows];
+    int nearest[kAssignBlockRows];
+    for (size_t block = begin; block < end; block += kAssignBlockRows) {
+      size_t rows = std::min(kAssignBlockRows, end - block);
+      AssignBlock(points.Row(block), stride, &point_norms[block], rows,
+                  packed, nearest, distances);
+
+      for (size_t r = 0; r < rows; r++) {
+        AccumulatePoint(points, block + r, nearest[r], distances[r], labels,
+                        partial);
       }
     }
-    clusters_[centroid].points_.push_back(curr_point);
-    labels_[i] = centroid;
-
-    // update worst distance of a cluster
-    if (lowest_distance > clusters_[centroid].worst_distance_) {
-      clusters_[centroid].worst_distance_ = lowest_distance;
-      clusters_[centroid].pos_of_worst_point_ =
-          clusters_[centroid].points_.size() - 1;
+    return;
+  }
+
+  for (size_t i = begin; i < end; i++) {
+    // check distance between each point and each cluster, padded rows are
+    // zero so the kernel can run over the full stride
+    double lowest_distance;
+    int centroid = kernels.nearest_centroid_(
+        points.Row(i), point_norms[i], centroids.Data(), centroid_norms.data(),
+        num_of_clusters_, stride, stride, &lowest_distance);
+
+    AccumulatePoint(points, i, centroid, lowest_distance, labels, partial);
+  }
+}
+
+void K_Means::ResetPartialSums(PartialSums& partial) {
+  size_t num_of_dimensions = points_->Cols();
+
+  // reset sums from previous iteration
+  partial.sums_.assign(num_of_clusters_ * num_of_dimensions, 0.0);
+  partial.counts_.assign(num_of_clusters_, 0);
+  partial.worst_distances_.assign(num_of_clusters_, 0.0);
+  partial.worst_points_.assign(num_of_clusters_, -1);
+  partial.sse_ = 0.0;
+  partial.num_of_distances_ = 0;
+  partial.points_moved_ = 0;
+}
+
+template <typename T>
+void K_Means::AccumulatePoint(const BasicMatrix<T>& points, size_t i,
+                              int centroid, double distance,
+                              std::vector<int>& labels, PartialSums& partial) {
+  size_t num_of_dimensions = points.Cols();
+  const T* point = points.Row(i);
+
+  // the norm expansion can round slightly below zero for points sitting on
+  // their centroid
+  distance = std::max(distance, 0.0);
+  partial.sse_ += distance;
+
+  // only a point that changed cluster touches the sums, it moves out of its
+  // previous cluster (none on the first pass of a run) into the new one
+  int previous = labels[i];
+  if (previous != centroid) {
+    double* sum = &partial.sums_[centroid * num_of_dimensions];
+    for (size_t j = 0; j < num_of_dimensions; j++) {
+      sum[j] += point[j];
+    }
+    partial.counts_[centroid]++;
+
+    if (previous != -1) {
+      double* previous_sum = &partial.sums_[previous * num_of_dimensions];
+      for (size_t j = 0; j < num_of_dimensions; j++) {
+        previous_sum[j] -= point[j];
+      }
+      partial.counts_[previous]--;
+      partial.points_moved_++;
+    }
+    labels[i] = centroid;
+  }
+
+  // update worst distance of a cluster
+  if (distance > partial.worst_distances_[centroid]) {
+    partial.worst_distances_[centroid] = distance;
+    partial.worst_points_[centroid] = static_cast<int>(i);
+  }
+}
+
+void K_Means::ReducePartialSums(RunState& state) {
+  size_t num_of_dimensions = points_->Cols();
+
+  for (int c = 0; c < num_of_clusters_; c++) {
+    Cluster& cluster = state.clusters_[c];
+    cluster.sum_.resize(num_of_dimensions, 0.0);
+    cluster.worst_distance_ = 0.0;
+    cluster.pos_of_worst_point_ = -1;
+
+    for (size_t w = 0; w < state.partial_sums_.size(); w++) {
+      const PartialSums& partial = state.partial_sums_[w];
+
+      const double* sum = &partial.sums_[c * num_of_dimensions];
+      for (size_t j = 0; j < num_of_dimensions; j++) {
+        cluster.sum_[j] += sum[j];
+      }
+      cluster.num_of_points_ += partial.counts_[c];
+
+      if (partial.worst_distances_[c] > cluster.worst_distance_) {
+        cluster.worst_distance_ = partial.worst_distances_[c];
+        cluster.pos_of_worst_point_ = partial.worst_points_[c];
+      }
+    }
+
+    // drop whatever rounding the running sum collected once it is empty
+    if (cluster.num_of_points_ == 0) {
+      cluster.sum_.assign(num_of_dimensions, 0.0);
     }
   }
 }
 
-void K_Means::UpdateCentroids() {
-  for (int i = 0; i < clusters_.size(); i++) {
-    if (clusters_[i].points_.empty()) {
+void K_Means::UpdateCentroids(RunState& state) {
+  for (size_t i = 0; i < state.clusters_.size(); i++) {
+    if (state.clusters_[i].num_of_points_ == 0) {
       // skip empty clusters
       continue;
     }
 
-    CalculateCentroid(clusters_[i]);
+    CalculateCentroid(state.clusters_[i]);
   }
 }
 
-void K_Means::CheckForSingletonClusters() {
+int K_Means::CheckForSingletonClusters(RunState& state) {
+  std::vector<Cluster>& clusters = state.clusters_;
+  int repairs = 0;
+
   for (int i = 0; i < num_of_clusters_; i++) {
-    if (clusters_[i].points_.size() <= 1) {
+    if (clusters[i].num_of_points_ <= 1) {
       // store to reduce multiple memory accesses
       double worst_distance = 0;
       int pos_of_worst_point = -1;
       int cluster_with_worst_point = -1;
 
       for (int j = 0; j < num_of_clusters_; j++) {
-        if (clusters_[j].points_.size() > 1 &&
-            clusters_[j].worst_distance_ > worst_distance) {
-          worst_distance = clusters_[j].worst_distance_;
-          pos_of_worst_point = clusters_[j].pos_of_worst_point_;
+        if (clusters[j].num_of_points_ > 1 &&
+            clusters[j].worst_distance_ > worst_distance) {
+          worst_distance = clusters[j].worst_distance_;
+          pos_of_worst_point = clusters[j].pos_of_worst_point_;
           cluster_with_worst_point = j;
         }
       }
 
       // update singleton cluster
       if (pos_of_worst_point != -1) {
-        clusters_[i].points_.push_back(
-            clusters_[cluster_with_worst_point].points_[pos_of_worst_point]);
-        clusters_[i].centroid_ = clusters_[i].points_[0];
+        std::span<const double> worst_point = (*points_)[pos_of_worst_point];
 
-        // Safely remove from source cluster
-        clusters_[cluster_with_worst_point].points_.erase(
-            clusters_[cluster_with_worst_point].points_.begin() +
-            pos_of_worst_point);
+        RemovePointFromCluster(clusters[cluster_with_worst_point],
+                               worst_point);
+        AddPointToCluster(clusters[i], worst_point);
+        state.labels_[pos_of_worst_point] = i;
+        clusters[i].centroid_.assign(worst_point.begin(), worst_point.end());
+        clusters[i].squared_norm_ =
+            (*squared_norms_points_)[pos_of_worst_point];
+        InvalidateBounds(state, pos_of_worst_point);
 
         // Update worst distance tracking for the source cluster
-        UpdateWorstDistance(cluster_with_worst_point);
+        UpdateWorstDistance(state, cluster_with_worst_point);
+        repairs++;
       }
     }
   }
+  return repairs;
 }
 
-void K_Means::UpdateWorstDistance(int cluster_index) {
-  clusters_[cluster_index].worst_distance_ = 0.0;
-  clusters_[cluster_index].pos_of_worst_point_ = -1;
+void K_Means::UpdateWorstDistance(RunState& state, int cluster_index) {
+  Cluster& cluster = state.clusters_[cluster_index];
+  cluster.worst_distance_ = 0.0;
+  cluster.pos_of_worst_point_ = -1;
 
   // check all of the points in the cluster to find the new worst distance
-  for (int i = 0; i < clusters_[cluster_index].points_.size(); i++) {
-    double distance = GetDistance(clusters_[cluster_index].points_[i],
-                                  clusters_[cluster_index].centroid_);
-    if (distance > clusters_[cluster_index].worst_distance_) {
-      clusters_[cluster_index].worst_distance_ = distance;
-      clusters_[cluster_index].pos_of_worst_point_ = i;
+  for (int i = 0; i < num_of_points_; i++) {
+    if (state.labels_[i] != cluster_index) continue;
+
+    double distance = GetDistance((*points_)[i], cluster.centroid_);
+    if (distance > cluster.worst_distance_) {
+      cluster.worst_distance_ = distance;
+      cluster.pos_of_worst_point_ = i;
     }
   }
 }
 
-K_Means::K_Means(Data* data, const InitializationMethod initialization_method)
-    : data_(data), kinitialization_method_(initialization_method) {
+K_Means::K_Means(Data* data, const InitializationMethod initialization_method,
+                 int num_of_threads)
+    : kinitialization_method_(initialization_method), data_(data) {
   // Making copies of these variables saves time
   num_of_points_ = data->GetNumOfPoints();
   num_of_clusters_ = data->GetNumOfClusters();
-  points_ = data->GetPoints();
-  true_labels_ = data->GetTrueLabels();
-  labels_.resize(num_of_points_, -1);
+  points_ = &data->GetPoints();
+  squared_norms_points_ = &data->GetSquaredNorms();
+  true_labels_ = &data->GetTrueLabels();
+
+  seed_ = std::random_device{}();
+  if (num_of_threads <= 0) {
+    num_of_threads =
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+  // one thread runs everything inline, a pool of one would only park a
+  // worker that never gets a block
+  if (num_of_threads > 1) {
+    thread_pool_ = std::make_unique<ThreadPool>(num_of_threads);
+  }
 }
 
-void K_Means::InitializeClusters() {
-  clusters_.clear();
-  clusters_.resize(num_of_clusters_);
+void K_Means::InitializeClusters(RunState& state, ThreadPool* pool) {
+  int k = num_of_clusters_;
+  Matrix& centroids = state.initial_centroids_;
+
+  if (warm_start_centroids_.Rows() > 0) {
+    size_t given = warm_start_centroids_.Rows();
+    centroids.Resize(k, warm_start_centroids_.Cols());
+    std::copy_n(warm_start_centroids_.Data(), given * centroids.Stride(),
+                centroids.Data());
+    if (!split_points_.empty()) {
+      std::discrete_distribution<> pick(split_weights_.begin(),
+                                        split_weights_.end());
+      int split = split_points_[pick(state.gen_)];
+      std::span<const double> split_point = (*points_)[split];
+      std::copy(split_point.begin(), split_point.end(), centroids.Row(given));
+    }
+  } else if (kinitialization_method_ ==
+             InitializationMethod::RANDOM_PARTITION) {
+    data_->PartitionCentroids(state.gen_, k, centroids);
+  } else if (kinitialization_method_ ==
+             InitializationMethod::RANDOM_SELECTION) {
+    data_->SelectCentroids(state.gen_, k, centroids);
+  } else if (kinitialization_method_ == InitializationMethod::MAX_I_MIN) {
+    data_->MaxIMinSelection(state.gen_, k, centroids);
+  } else if (kinitialization_method_ ==
+             InitializationMethod::KMEANS_PLUS_PLUS) {
+    data_->KMeansPlusPlus(state.gen_, k, centroids);
+  } else if (kinitialization_method_ ==
+             InitializationMethod::KMEANS_PARALLEL) {
+    data_->KMeansParallel(state.gen_, k, centroids, pool);
+  }
+
+  // the clusters of the previous restart are reset in place, keeping their
+  // vectors
+  state.clusters_.resize(num_of_clusters_);
   for (int i = 0; i < num_of_clusters_; i++) {
-    clusters_[i].centroid_ = data_->GetCentroids()[i];
-    clusters_[i].worst_distance_ = 0.0;
-    clusters_[i].pos_of_worst_point_ = -1;
+    Cluster& cluster = state.clusters_[i];
+    std::span<const double> centroid = state.initial_centroids_[i];
+    cluster.centroid_.assign(centroid.begin(), centroid.end());
+    cluster.squared_norm_ = CalculateSquaredNorm(centroid);
+    cluster.sum_.assign(centroid.size(), 0.0);
+    cluster.num_of_points_ = 0;
+    cluster.worst_distance_ = 0.0;
+    cluster.pos_of_worst_point_ = -1;
   }
 }
 
-void K_Means::Run() {
-  for (int i = 0; i < data_->GetNumOfRuns(); i++) {
-    sse_ = std::numeric_limits<double>::max();
+void K_Means::RunOnce(int run, RunState& state, ThreadPool* pool) {
+  std::seed_seq seq{seed_, static_cast<unsigned int>(run)};
+  state.gen_.seed(seq);
+  state.sse_ = std::numeric_limits<double>::max();
+  state.initial_sse_ = std::numeric_limits<double>::max();
+  state.num_of_iterations_ = -1;
+  state.num_of_distance_evaluations_ = 0;
+  state.steady_state_allocations_ = 0;
+  state.bounds_valid_ = false;
+  state.labels_.assign(num_of_points_, -1);
+  if (algorithm_ == Algorithm::FILTERING) {
+    state.cell_labels_.assign(kd_tree_->NumOfNodes(), -1);
+  }
+  state.partial_sums_.resize(pool != nullptr ? pool->GetNumOfThreads() : 1);
 
 #if VERBOSE_OUTPUT
-    std::cout << "\nRun " << i + 1 << "\n-----\n";
+  std::cout << "\nRun " << run + 1 << "\n-----\n";
 #endif
 
-    if (kinitialization_method_ == InitializationMethod::RANDOM_PARTITION)
-      data_->PartitionCentroids();
-    else if (kinitialization_method_ == InitializationMethod::RANDOM_SELECTION)
-      data_->SelectCentroids();
-    else if (kinitialization_method_ == InitializationMethod::MAX_I_MIN)
-      data_->MaxIMinSelection();
+  state.profile_.Begin(data_->GetFileName(), num_of_clusters_, run);
+  {
+    ScopedTimer run_timer(state.profile_, Phase::RUN, -1);
+    RunIterations(state, pool);
+  }
+  state.profile_.End();
+}
 
-    InitializeClusters();
+void K_Means::RunIterations(RunState& state, ThreadPool* pool) {
+  RunProfile& profile = state.profile_;
 
-    for (int iter = 0; iter < data_->GetMaxIterations(); iter++) {
-#if CHECK_PERFORMANCE
-      auto iter_start = std::chrono::high_resolution_clock::now();
-#endif
+  {
+    ScopedTimer timer(profile, Phase::INITIALIZATION, 0);
+    InitializeClusters(state, pool);
+  }
 
-      AssignPointsToClusters();
+  if (algorithm_ == Algorithm::MINI_BATCH) {
+    RunMiniBatch(state, pool);
+    return;
+  }
 
-#if CHECK_PERFORMANCE
-      auto iter_stop = std::chrono::high_resolution_clock::now();
-      auto iter_duration =
-          std::chrono::duration_cast<std::chrono::milliseconds>(iter_stop -
-                                                                iter_start);
-      std::cout << "Assigning points took: " << iter_duration.count()
-                << " milliseconds" << std::endl;
-#endif
+  for (int iter = 0; iter < data_->GetMaxIterations(); iter++) {
+    int iteration = iter + 1;
+    uint64_t allocations_before = CountAllocations(pool);
+    long long distances_before = state.num_of_distance_evaluations_;
+    double sse;
+    {
+      ScopedTimer timer(profile, Phase::ASSIGNMENT, iteration);
+      sse = AssignPointsToClusters(state, pool);
+    }
+    profile.RecordCounter(
+        Counter::DISTANCE_EVALUATIONS, iteration,
+        state.num_of_distance_evaluations_ - distances_before);
+    profile.RecordCounter(Counter::POINTS_MOVED, iteration,
+                          state.points_moved_);
+
+    if (iter == 0) {
+      state.initial_sse_ = sse;
+    }
 
-#if CHECK_PERFORMANCE
-      iter_start = std::chrono::high_resolution_clock::now();
+#if VERBOSE_OUTPUT
+    std::cout << "Iteration " << iteration << ": SSE = " << sse << std::endl;
 #endif
 
-      double sse = CalculateSSE(clusters_);
+    if (data_->GetConvergenceThreshold() >= (state.sse_ - sse)) {
+      state.sse_ = sse;
+      state.num_of_iterations_ = iteration;
+      RecordAllocations(state, pool, iteration, allocations_before);
+      break;
+    }
+    state.sse_ = sse;
 
-      if (iter == 0) {
-        if (sse < best_initial_sse_) {
-          best_initial_sse_ = sse;
-        }
-      }
+    int repairs;
+    {
+      ScopedTimer timer(profile, Phase::SINGLETON_REPAIR, iteration);
+      repairs = CheckForSingletonClusters(state);
+    }
+    profile.RecordCounter(Counter::EMPTY_CLUSTER_REPAIRS, iteration, repairs);
 
-#if VERBOSE_OUTPUT
-      std::cout << "Iteration " << iter + 1 << ": SSE = " << sse << std::endl;
-#endif
+    {
+      ScopedTimer timer(profile, Phase::CENTROID_UPDATE, iteration);
+      UpdateCentroids(state);
+    }
+    RecordAllocations(state, pool, iteration, allocations_before);
+  }
+}
 
-      if (data_->GetConvergenceThreshold() >= (sse_ - sse)) {
-        sse_ = sse;
-        if (iter + 1 < best_num_of_iterations_) {
-          best_num_of_iterations_ = iter + 1;
-        }
+void K_Means::RecordAllocations(RunState& state, ThreadPool* pool,
+                                int iteration, uint64_t allocations_before) {
+  long long allocations =
+      static_cast<long long>(CountAllocations(pool) - allocations_before);
+  state.profile_.RecordCounter(Counter::ALLOCATIONS, iteration, allocations);
+  if (iteration > kWarmUpIterations) {
+    state.steady_state_allocations_ += allocations;
+  }
+}
 
-        break;
-      }
-      sse_ = sse;
-
-#if CHECK_PERFORMANCE
-      iter_stop = std::chrono::high_resolution_clock::now();
-      iter_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-          iter_stop - iter_start);
-      std::cout << "Calculating SSE took: " << iter_duration.count()
-                << " milliseconds" << std::endl;
-#endif
+void K_Means::RecordRun(int run, const RunState& state, RunSummary& summary) {
+  // run external validation metrics, unlabeled datasets have nothing to
+  // compare against
+  if (!true_labels_->empty()) {
+    KeepHighestScores(
+        external_validation_.Evaluate(*true_labels_, state.labels_),
+        summary.highest_scores_);
+  }
 
-#if CHECK_PERFORMANCE
-      iter_start = std::chrono::high_resolution_clock::now();
-#endif
+  if (state.initial_sse_ < summary.best_initial_sse_) {
+    summary.best_initial_sse_ = state.initial_sse_;
+  }
 
-      CheckForSingletonClusters();
+  summary.num_of_distance_evaluations_ += state.num_of_distance_evaluations_;
+  summary.steady_state_allocations_ += state.steady_state_allocations_;
 
-#if CHECK_PERFORMANCE
-      iter_stop = std::chrono::high_resolution_clock::now();
-      iter_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-          iter_stop - iter_start);
-      std::cout << "Check for singleton clusters took: "
-                << iter_duration.count() << " milliseconds" << std::endl;
-#endif
+  if (state.num_of_iterations_ != -1 &&
+      state.num_of_iterations_ < summary.best_num_of_iterations_) {
+    summary.best_num_of_iterations_ = state.num_of_iterations_;
+  }
 
-#if CHECK_PERFORMANCE
-      iter_start = std::chrono::high_resolution_clock::now();
-#endif
+  // keep track of best run, ties go to the earliest run as they would when
+  // running serially
+  if (state.sse_ < summary.lowest_final_sse_ ||
+      (state.sse_ == summary.lowest_final_sse_ && run < summary.best_run_)) {
+    summary.lowest_final_sse_ = state.sse_;
+    summary.best_run_ = run;
+    summary.best_clusters_ = state.clusters_;
+    summary.best_labels_ = state.labels_;
+  }
 
-      UpdateCentroids();
+  // the last restart's state stays visible through GetClusters()/GetLabels()
+  if (run == num_of_runs_ - 1) {
+    clusters_ = state.clusters_;
+    labels_ = state.labels_;
+  }
+}
 
-#if CHECK_PERFORMANCE
-      iter_stop = std::chrono::high_resolution_clock::now();
-      iter_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
-          iter_stop - iter_start);
-      std::cout << "Updating centroids took: " << iter_duration.count()
-                << " milliseconds" << std::endl;
-#endif
+// the bound algorithms in k_means_bounds.cc accumulate double points
+template void K_Means::AccumulatePoint<double>(const Matrix& points, size_t i,
+                                               int centroid, double distance,
+                                               std::vector<int>& labels,
+                                               PartialSums& partial);
+
+void K_Means::Run() {
+  // a warm start without split points is deterministic, restarting it would
+  // repeat the same run
+  bool deterministic =
+      warm_start_centroids_.Rows() > 0 && split_points_.empty();
+  num_of_runs_ = deterministic ? 1 : data_->GetNumOfRuns();
+  int num_of_runs = num_of_runs_;
+  int num_of_threads =
+      thread_pool_ != nullptr ? thread_pool_->GetNumOfThreads() : 1;
+
+  // results of a previous call, e.g. for another k, are not merged into
+  highest_scores_ = ExternalScores();
+  num_of_distance_evaluations_ = 0;
+  num_of_steady_state_allocations_ = 0;
+  lowest_final_sse_ = std::numeric_limits<double>::max();
+  best_initial_sse_ = std::numeric_limits<double>::max();
+  best_num_of_iterations_ = std::numeric_limits<int>::max();
+  best_clusters_.clear();
+  best_labels_.clear();
+
+  // built once here, restarts only read it
+  if (UsesFloat()) {
+    float_points_ = &data_->GetFloatPoints();
+    float_squared_norms_points_ = &data_->GetFloatSquaredNorms();
+  }
+  if (algorithm_ == Algorithm::FILTERING) kd_tree_ = &data_->GetKdTree();
+
+  // with enough restarts to keep every thread busy each worker runs whole
+  // restarts on its own, otherwise restarts run one at a time and split their
+  // points across the pool
+  bool parallel_runs = num_of_threads > 1 && num_of_runs >= num_of_threads;
+
+  std::vector<RunSummary> summaries;
+
+  if (run_states_.size() < static_cast<size_t>(num_of_threads)) {
+    run_states_.resize(num_of_threads);
+  }
+
+  if (parallel_runs) {
+    std::vector<RunState>& states = run_states_;
+    summaries.resize(num_of_threads);
+    std::atomic<int> next_run{0};
+
+    thread_pool_->ParallelFor(
+        num_of_threads, [&](size_t /*begin*/, size_t /*end*/, int worker) {
+          for (int run = next_run++; run < num_of_runs; run = next_run++) {
+            RunOnce(run, states[worker], nullptr);
+            RecordRun(run, states[worker], summaries[worker]);
+          }
+        });
+  } else {
+    RunState& state = run_states_[0];
+    summaries.resize(1);
+    for (int run = 0; run < num_of_runs; run++) {
+      RunOnce(run, state, thread_pool_.get());
+      RecordRun(run, state, summaries[0]);
     }
+  }
 
-    // run external validation metrics
-    double rand_index = external_validation_->RandIndex(true_labels_, labels_);
-    double jaccard_index =
-        external_validation_->JaccardIndex(true_labels_, labels_);
+  // merge what each worker saw
+  int best_run = -1;
+  for (size_t w = 0; w < summaries.size(); w++) {
+    const RunSummary& summary = summaries[w];
 
-    if (rand_index > highest_rand_index_) {
-      highest_rand_index_ = rand_index;
+    KeepHighestScores(summary.highest_scores_, highest_scores_);
+
+    num_of_distance_evaluations_ += summary.num_of_distance_evaluations_;
+    num_of_steady_state_allocations_ += summary.steady_state_allocations_;
+
+    if (summary.best_initial_sse_ < best_initial_sse_) {
+      best_initial_sse_ = summary.best_initial_sse_;
     }
 
-    if (jaccard_index > highest_jaccard_index_) {
-      highest_jaccard_index_ = jaccard_index;
+    if (summary.best_num_of_iterations_ < best_num_of_iterations_) {
+      best_num_of_iterations_ = summary.best_num_of_iterations_;
     }
 
-    // keep track of best run
-    if (sse_ < lowest_final_sse_) {
-      lowest_final_sse_ = sse_;
-      lowest_final_sse_run_ = i + 1;
-      best_clusters_ = clusters_;
+    if (summary.best_run_ == -1) continue;
+    if (summary.lowest_final_sse_ < lowest_final_sse_ ||
+        (summary.lowest_final_sse_ == lowest_final_sse_ && best_run != -1 &&
+         summary.best_run_ < best_run)) {
+      lowest_final_sse_ = summary.lowest_final_sse_;
+      best_run = summary.best_run_;
+      best_clusters_ = summary.best_clusters_;
+      best_labels_ = summary.best_labels_;
     }
   }
 
+  if (best_run != -1) {
+    lowest_final_sse_run_ = best_run + 1;
+  }
+
 #if VERBOSE_OUTPUT
   std::cout << "\nBest Run: " << lowest_final_sse_run_
             << ": SSE = " << lowest_final_sse_ << std::endl;
 #endif
 }
 
-void K_Means::exportResults() {
+void K_Means::exportResults(std::ostream& out) {
   if (data_->GetNormalizationMethod() == NormalizationMethod::Z_SCORE) {
-    std::cout << "Z-Score Normalization,";
+    out << "Z-Score Normalization,";
   } else if (data_->GetNormalizationMethod() == NormalizationMethod::MIN_MAX) {
-    std::cout << "Min-Max Normalization,";
+    out << "Min-Max Normalization,";
   }
 
   if (kinitialization_method_ == InitializationMethod::RANDOM_PARTITION) {
-    std::cout << "Random Partitioning,";
+    out << "Random Partitioning,";
   } else if (kinitialization_method_ ==
              InitializationMethod::RANDOM_SELECTION) {
-    std::cout << "Random Initialization,";
+    out << "Random Initialization,";
   } else if (kinitialization_method_ == InitializationMethod::MAX_I_MIN) {
-    std::cout << "Max-I-Min Initialization,";
+    out << "Max-I-Min Initialization,";
+  } else if (kinitialization_method_ ==
+             InitializationMethod::KMEANS_PLUS_PLUS) {
+    out << "K-Means++ Initialization,";
+  } else if (kinitialization_method_ ==
+             InitializationMethod::KMEANS_PARALLEL) {
+    out << "K-Means|| Initialization,";
   }
 
-  std::cout << best_initial_sse_ << "," << lowest_final_sse_ << ","
-            << best_num_of_iterations_;
+  out << best_initial_sse_ << "," << lowest_final_sse_ << ","
+      << best_num_of_iterations_;
 }
@@ -7,64 +7,323 @@
 #define K_MEANS_H_
 
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <random>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include "../data/cluster.h"
 #include "../data/data.h"
+#include "../data/kd_tree.h"
+#include "../data/matrix.h"
 #include "../external_validation/external_val.h"
+#include "../util/allocation_counter.h"
+#include "../util/ball_tree.h"
+#include "../util/blocked_assign.h"
 #include "../util/config.h"
+#include "../util/instrumentation.h"
 #include "../util/math.h"
+#include "../util/thread_pool.h"
 
 class K_Means {
  private:
   const InitializationMethod kinitialization_method_;
+  Algorithm algorithm_ = Algorithm::LLOYD;
+  int batch_size_ = MINI_BATCH_SIZE;
+  Precision precision_ = Precision::FLOAT64;
 
   int num_of_points_;
   int num_of_clusters_;
-  std::vector<std::vector<double>> points_;
-  std::vector<double> squared_norms_points_;
+  int num_of_runs_;
+  // when set, every restart starts from these instead of being initialized.
+  // With split_points_ each restart adds one more centroid, drawn from those
+  // points with probability proportional to split_weights_
+  Matrix warm_start_centroids_;
+  std::vector<int> split_points_;
+  std::vector<double> split_weights_;
+  const Matrix *points_;
+  const FloatMatrix *float_points_ = nullptr;  // set by Run() in FLOAT32 mode
+  // ||x||^2 per point, cached by Data so no restart or iteration recomputes
+  const std::vector<double> *squared_norms_points_;
+  const std::vector<float> *float_squared_norms_points_ = nullptr;
+  const KdTree *kd_tree_ = nullptr;  // set by Run() for FILTERING
 
   int lowest_final_sse_run_;
   double lowest_final_sse_ = std::numeric_limits<double>::max();
-  double sse_;
 
   double best_initial_sse_ = std::numeric_limits<double>::max();
   int best_num_of_iterations_ = std::numeric_limits<int>::max();
 
   std::vector<Cluster> clusters_;
   std::vector<Cluster> best_clusters_;
-  std::vector<double> squared_norms_centroids_;
 
   std::vector<int> labels_;
-  std::vector<int> true_labels_;
-  double highest_rand_index_ = std::numeric_limits<double>::min();
-  double highest_jaccard_index_ = std::numeric_limits<double>::min();
+  std::vector<int> best_labels_;
+  const std::vector<int> *true_labels_;
+  ExternalScores highest_scores_;
+  long long num_of_distance_evaluations_ = 0;
+  long long num_of_steady_state_allocations_ = 0;
 
   Data *data_;
-  ExternalValidation *external_validation_ = new ExternalValidation();
+  ExternalValidation external_validation_;
 
-  void AssignPointsToClusters();
-  void UpdateCentroids();
-  void InitializeClusters();
-  void CheckForSingletonClusters();
-  void UpdateWorstDistance(int cluster_index);
+  // restart i draws from a generator seeded with (seed_, i), so results do not
+  // depend on which worker picks up which restart
+  unsigned int seed_;
+
+  // each worker accumulates into its own copy during assignment, the copies
+  // are reduced into the run's clusters once every worker has finished. sums_
+  // and counts_ only hold the change caused by points that switched cluster,
+  // the clusters keep running totals
+  struct PartialSums {
+    std::vector<double> sums_;  // num_of_clusters_ x num_of_dimensions
+    std::vector<int> counts_;
+    std::vector<double> worst_distances_;
+    std::vector<int> worst_points_;
+    double sse_;
+    long long num_of_distances_;
+    long long points_moved_;  // points whose label changed
+    std::vector<double> distances_;  // scratch, one point's distances
+    // FILTERING scratch, the candidate lists of the cells being visited and
+    // the midpoint of the current cell
+    std::vector<int> candidates_;
+    std::vector<double> midpoint_;
+    // BALL_TREE scratch, the candidates of the current group (k rows, the
+    // first ones used) packed for the kernels and a block of its points
+    // gathered into contiguous rows
+    Matrix candidate_centroids_;
+    std::vector<double> candidate_norms_;
+    PackedCentroids packed_candidates_;
+    Matrix block_points_;
+  };
+
+  // everything a single restart mutates, one per worker so restarts can run
+  // side by side
+  struct RunState {
+    std::mt19937 gen_;
+    Matrix initial_centroids_;
+    std::vector<Cluster> clusters_;
+    Matrix centroids_;  // padded copy of the centroids for the kernels
+    PackedCentroids packed_centroids_;
+    std::vector<int> labels_;
+    std::vector<double> squared_norms_centroids_;
+    std::vector<PartialSums> partial_sums_;
+
+    // single precision copies read by the assignment in FLOAT32 mode
+    FloatMatrix float_centroids_;
+    PackedFloatCentroids packed_float_centroids_;
+    std::vector<float> float_norms_centroids_;
+
+    // triangle inequality state for Hamerly, Elkan and Yinyang, distances
+    // are Euclidean (not squared). lower_bounds_ holds BoundsPerPoint()
+    // bounds for every point.
+    bool bounds_valid_;
+    std::vector<double> lower_bounds_;
+    Matrix previous_centroids_;
+    std::vector<double> drifts_;
+    std::vector<double> centroid_distances_;  // k x k, Elkan only
+    std::vector<double> half_separations_;  // half distance to nearest other
+    double max_drift_;
+    double second_max_drift_;
+    int max_drift_cluster_;
+
+    // Yinyang groups of centroids, fixed for the whole run
+    std::vector<std::vector<int>> groups_;
+    std::vector<int> group_of_cluster_;
+    std::vector<double> group_drifts_;
+
+    // FILTERING: the label every point of a tree node carries, -1 before the
+    // first pass and kMixedCell once they differ. Workers each take cells
+    // from frontier_, above_frontier_ holds the nodes above those
+    std::vector<int> cell_labels_;
+    std::vector<int> frontier_;
+    std::vector<int> above_frontier_;
+
+    // BALL_TREE: the tree over the centroids and the points grouped by their
+    // previous label, group c is label_order_[label_starts_[c],
+    // label_starts_[c + 1]) and label_distances_ holds the squared distance
+    // of each of them to c
+    BallTree centroid_tree_;
+    std::vector<int> label_order_;
+    std::vector<int> label_starts_;
+    std::vector<int> label_next_;
+    std::vector<double> label_distances_;
+
+    RunProfile profile_;
+    long long points_moved_;  // by the latest assignment pass
+
+    double initial_sse_;
+    double sse_;
+    int num_of_iterations_;  // -1 when the run hit max iterations
+    long long num_of_distance_evaluations_;
+    // heap allocations of the iterations after kWarmUpIterations, see
+    // CountAllocations
+    long long steady_state_allocations_;
+  };
+
+  // best results seen by one worker, merged after every restart is done
+  struct RunSummary {
+    int best_run_ = -1;
+    double lowest_final_sse_ = std::numeric_limits<double>::max();
+    double best_initial_sse_ = std::numeric_limits<double>::max();
+    int best_num_of_iterations_ = std::numeric_limits<int>::max();
+    ExternalScores highest_scores_;
+    long long num_of_distance_evaluations_ = 0;
+    long long steady_state_allocations_ = 0;
+    std::vector<Cluster> best_clusters_;
+    std::vector<int> best_labels_;
+  };
+
+  std::unique_ptr<ThreadPool> thread_pool_;  // nullptr with a single thread
+  // one per worker, kept across restarts and calls to Run() so the scratch
+  // they hold is allocated once and only reset after that
+  std::vector<RunState> run_states_;
+
+  // pool is the pool used to split a single restart, nullptr runs it on the
+  // calling thread
+  double AssignPointsToClusters(RunState &state, ThreadPool *pool);
+  void AssignPointsInRange(RunState &state, size_t begin, size_t end,
+                           PartialSums &partial);
+  template <typename T>
+  void AssignPointsInRange(const BasicMatrix<T> &points,
+                           const std::vector<T> &point_norms,
+                           const BasicMatrix<T> &centroids,
+                           const std::vector<T> &centroid_norms,
+                           const BasicPackedCentroids<T> &packed,
+                           std::vector<int> &labels, size_t begin, size_t end,
+                           PartialSums &partial);
+  void PrepareFloatCentroids(RunState &state);
+  bool UsesFloat() {
+    return precision_ == Precision::FLOAT32 && !UsesBounds() &&
+           algorithm_ != Algorithm::FILTERING && !UsesCentroidTree();
+  }
+  bool UsesCentroidTree() {
+    return algorithm_ == Algorithm::BALL_TREE &&
+           num_of_clusters_ >= BALL_TREE_MIN_K;
+  }
+  void ResetPartialSums(PartialSums &partial);
+
+  // triangle inequality accelerated assignment, see k_means_bounds.cc
+  void UpdateCentroidBounds(RunState &state);
+  void AssignPointsInRangeHamerly(RunState &state, size_t begin, size_t end,
+                                  PartialSums &partial);
+  void AssignPointsInRangeElkan(RunState &state, size_t begin, size_t end,
+                                PartialSums &partial);
+  void GroupCentroids(RunState &state);
+  void AssignPointsInRangeYinyang(RunState &state, size_t begin, size_t end,
+                                  PartialSums &partial);
+  size_t BoundsPerPoint(const RunState &state);
+  void InvalidateBounds(RunState &state, int point);
+
+  // KD-tree filtering assignment, see k_means_filtering.cc
+  static constexpr int kMixedCell = -2;
+  void FilterPoints(RunState &state, ThreadPool *pool);
+  void FindFrontier(RunState &state, size_t num_of_cells);
+  void FilterCell(RunState &state, int node, size_t offset, int count,
+                  PartialSums &partial);
+  void AssignCell(RunState &state, int node, int centroid,
+                  PartialSums &partial);
+  void RefreshWorstDistances(RunState &state);
+
+  // assignment through a ball tree over the centroids, see
+  // k_means_ball_tree.cc
+  void AssignPointsBallTree(RunState &state, ThreadPool *pool);
+  void AssignGroup(RunState &state, int group, PartialSums &partial);
+
+  // records point i's new label, sums are kept in double whatever the scalar
+  // type of points
+  template <typename T>
+  void AccumulatePoint(const BasicMatrix<T> &points, size_t i, int centroid,
+                       double distance, std::vector<int> &labels,
+                       PartialSums &partial);
+  void ReducePartialSums(RunState &state);
+  void UpdateCentroids(RunState &state);
+  void InitializeClusters(RunState &state, ThreadPool *pool);
+  // returns the number of clusters repaired
+  int CheckForSingletonClusters(RunState &state);
+  void UpdateWorstDistance(RunState &state, int cluster_index);
+  void RunOnce(int run, RunState &state, ThreadPool *pool);
+  // the first passes of a restart size its scratch (the second is the first
+  // one with bounds or label groups), later iterations should not allocate
+  static constexpr int kWarmUpIterations = 2;
+  void RunIterations(RunState &state, ThreadPool *pool);
+  // allocations a restart can have made so far. Split across a pool it is
+  // the only restart running and its blocks run on the workers, so every
+  // thread counts; run on its own it is the calling thread's count
+  static uint64_t CountAllocations(ThreadPool *pool) {
+    return pool != nullptr ? AllocationCounter::Total()
+                           : AllocationCounter::ThisThread();
+  }
+  void RecordAllocations(RunState &state, ThreadPool *pool, int iteration,
+                         uint64_t allocations_before);
+
+  // mini-batch iterations, see k_means_mini_batch.cc
+  void RunMiniBatch(RunState &state, ThreadPool *pool);
+  bool UsesBounds() {
+    return algorithm_ == Algorithm::HAMERLY ||
+           algorithm_ == Algorithm::ELKAN || algorithm_ == Algorithm::YINYANG;
+  }
+  void RecordRun(int run, const RunState &state, RunSummary &summary);
 
  public:
   explicit K_Means(Data *data,
                    const InitializationMethod initialization_method =
-                       InitializationMethod::RANDOM_PARTITION);
+                       InitializationMethod::RANDOM_PARTITION,
+                   int num_of_threads = NUM_OF_THREADS);
 
+  // results only cover the restarts of the latest call, so Run() can be
+  // called again after e.g. SetNumOfClusters
   void Run();
-  void exportResults();
+  // writes the CSV fields after the dataset name of one results row
+  void exportResults(std::ostream &out = std::cout);
+
+  void SetSeed(unsigned int seed) { seed_ = seed; }
+  void SetAlgorithm(Algorithm algorithm) { algorithm_ = algorithm; }
+  void SetBatchSize(int batch_size) { batch_size_ = batch_size; }
+  void SetPrecision(Precision precision) { precision_ = precision; }
+  // overrides the dataset's k, so one Data can back runs with different k
+  void SetNumOfClusters(int k) { num_of_clusters_ = k; }
+  // starts from centroids instead of the initialization method, Run() then
+  // does a single restart since every restart would be the same
+  void SetInitialCentroids(const Matrix &centroids) {
+    warm_start_centroids_ = centroids;
+    split_points_.clear();
+    split_weights_.clear();
+    num_of_clusters_ = static_cast<int>(centroids.Rows());
+  }
+  // starts from centroids plus one centroid each restart draws from
+  // split_points (weighted by split_weights) with its own generator, so the
+  // restarts still differ and Run() does all of them
+  void SetInitialCentroids(const Matrix &centroids,
+                           std::vector<int> split_points,
+                           std::vector<double> split_weights) {
+    warm_start_centroids_ = centroids;
+    split_points_ = std::move(split_points);
+    split_weights_ = std::move(split_weights);
+    num_of_clusters_ = static_cast<int>(centroids.Rows()) + 1;
+  }
 
-  std::vector<Cluster> GetClusters() { return clusters_; };
-  std::vector<Cluster> GetBestClusters() { return best_clusters_; };
-  std::vector<int> GetLabels() { return labels_; };
-  double GetRandIndex() { return highest_rand_index_; };
-  double GetJaccardIndex() { return highest_jaccard_index_; };
+  const std::vector<Cluster> &GetClusters() { return clusters_; };
+  const std::vector<Cluster> &GetBestClusters() { return best_clusters_; };
+  const std::vector<int> &GetLabels() { return labels_; };
+  const std::vector<int> &GetBestLabels() { return best_labels_; };
+  double GetLowestFinalSSE() { return lowest_final_sse_; };
+  double GetRandIndex() { return highest_scores_.rand_index_; };
+  double GetJaccardIndex() { return highest_scores_.jaccard_index_; };
+  // best of every external score over the restarts
+  const ExternalScores &GetExternalScores() { return highest_scores_; };
+  long long GetNumOfDistanceEvaluations() {
+    return num_of_distance_evaluations_;
+  };
+  // heap allocations made by the iteration loops of every restart once they
+  // are past kWarmUpIterations, 0 unless something reallocates scratch
+  long long GetNumOfSteadyStateAllocations() {
+    return num_of_steady_state_allocations_;
+  };
 };
 
 #endif  // K_MEANS_H_
@@ -0,0 +1,180 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+/*
+Ball tree assignment for large k
+
+After the first pass every point has a label, so the points are grouped by
+the centroid c they were assigned to last. For a member x of the group of c,
+any centroid z closer to x than c satisfies
+
+  ||z - c|| <= ||z - x|| + ||x - c|| <= 2 ||x - c||
+
+so with r the distance from c to its furthest member, only the centroids
+within 2r of c can win for any member. One range query against a ball tree
+over the centroids finds them, then the members are scored against those
+candidates only, with the same blocked kernels as the Lloyd loop. Candidates
+stay in index order, so ties still go to the lowest index.
+
+Tight clusters far from the others end up with a handful of candidates;
+a group with a far outlier falls back to close to a full scan.
+*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "./k_means.h"
+
+namespace {
+
+// the range is widened by this fraction of the centroid's norm so rounding
+// in the norm-trick distances cannot drop the centroid Lloyd would pick
+constexpr double kRadiusSlack = 1e-9;
+
+}  // namespace
+
+void K_Means::AssignPointsBallTree(RunState& state, ThreadPool* pool) {
+  // counting sort of the points by their previous label
+  std::vector<int>& starts = state.label_starts_;
+  starts.assign(num_of_clusters_ + 1, 0);
+  for (int i = 0; i < num_of_points_; i++) starts[state.labels_[i] + 1]++;
+  for (int c = 0; c < num_of_clusters_; c++) starts[c + 1] += starts[c];
+
+  state.label_order_.resize(num_of_points_);
+  std::vector<int>& next = state.label_next_;
+  next.assign(starts.begin(), starts.end() - 1);
+  for (int i = 0; i < num_of_points_; i++) {
+    state.label_order_[next[state.labels_[i]]++] = i;
+  }
+
+  // every scratch vector gets its largest possible size up front, so later
+  // passes never grow one
+  state.label_distances_.resize(num_of_points_);
+  size_t num_of_dimensions = points_->Cols();
+  size_t num_of_panels =
+      (num_of_clusters_ + kCentroidPanelWidth - 1) / kCentroidPanelWidth;
+  for (PartialSums& partial : state.partial_sums_) {
+    PackedCentroids& packed = partial.packed_candidates_;
+    partial.candidates_.reserve(num_of_clusters_);
+    partial.candidate_norms_.reserve(num_of_clusters_);
+    packed.data_.reserve(num_of_panels * num_of_dimensions *
+                         kCentroidPanelWidth);
+    packed.norms_.reserve(num_of_panels * kCentroidPanelWidth);
+    Matrix& candidate_centroids = partial.candidate_centroids_;
+    if (candidate_centroids.Rows() != static_cast<size_t>(num_of_clusters_)) {
+      candidate_centroids.Resize(num_of_clusters_, num_of_dimensions);
+    }
+    if (partial.block_points_.Empty()) {
+      partial.block_points_.Resize(kAssignBlockRows, num_of_dimensions);
+    }
+  }
+
+  auto assign_groups = [this, &state](size_t begin, size_t end,
+                                      PartialSums& partial) {
+    ResetPartialSums(partial);
+    for (size_t c = begin; c < end; c++) {
+      AssignGroup(state, static_cast<int>(c), partial);
+    }
+  };
+
+  if (pool != nullptr) {
+    pool->ParallelFor(num_of_clusters_,
+                      [&state, &assign_groups](size_t begin, size_t end,
+                                               int worker) {
+                        assign_groups(begin, end, state.partial_sums_[worker]);
+                      });
+  } else {
+    assign_groups(0, num_of_clusters_, state.partial_sums_[0]);
+  }
+}
+
+void K_Means::AssignGroup(RunState& state, int group, PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  const Matrix& centroids = state.centroids_;
+  size_t num_of_dimensions = points_->Cols();
+  size_t stride = points_->Stride();
+
+  int first_member = state.label_starts_[group];
+  const int* members = &state.label_order_[first_member];
+  double* distances = &state.label_distances_[first_member];
+  int size = state.label_starts_[group + 1] - first_member;
+  if (size == 0) return;
+
+  double furthest = 0.0;
+  for (int m = 0; m < size; m++) {
+    distances[m] = kernels.squared_distance_(points_->Row(members[m]),
+                                             centroids.Row(group), stride);
+    furthest = std::max(furthest, distances[m]);
+  }
+  partial.num_of_distances_ += size;
+
+  double radius =
+      2 * std::sqrt(furthest) +
+      kRadiusSlack * (1 + std::sqrt(state.squared_norms_centroids_[group]));
+  std::vector<int>& candidates = partial.candidates_;
+  state.centroid_tree_.Within(centroids.Row(group), radius, candidates,
+                              &partial.num_of_distances_);
+
+  // nothing else is near enough, the whole group stays
+  int count = static_cast<int>(candidates.size());
+  if (count <= 1) {
+    for (int m = 0; m < size; m++) {
+      AccumulatePoint(*points_, members[m], group, distances[m],
+                      state.labels_, partial);
+    }
+    return;
+  }
+
+  // the first count rows of the scratch matrix, viewed as a matrix of their
+  // own for the packing
+  Matrix candidate_centroids(partial.candidate_centroids_.Data(), count,
+                             num_of_dimensions, stride);
+  partial.candidate_norms_.resize(count);
+  for (int c = 0; c < count; c++) {
+    std::copy_n(centroids.Row(candidates[c]), num_of_dimensions,
+                candidate_centroids.Row(c));
+    partial.candidate_norms_[c] =
+        state.squared_norms_centroids_[candidates[c]];
+  }
+  partial.num_of_distances_ += static_cast<long long>(size) * count;
+
+  if (count < BLOCKED_ASSIGN_MIN_K) {
+    for (int m = 0; m < size; m++) {
+      int point = members[m];
+      double lowest_distance;
+      int nearest = kernels.nearest_centroid_(
+          points_->Row(point), (*squared_norms_points_)[point],
+          candidate_centroids.Data(), partial.candidate_norms_.data(), count,
+          stride, stride, &lowest_distance);
+      AccumulatePoint(*points_, point, candidates[nearest], lowest_distance,
+                      state.labels_, partial);
+    }
+    return;
+  }
+
+  // the members are scattered over the points, each block is gathered into
+  // contiguous rows for the blocked kernel
+  PackCentroids(candidate_centroids, partial.candidate_norms_.data(),
+                partial.packed_candidates_);
+  Matrix& block = partial.block_points_;
+  double block_norms[kAssignBlockRows];
+  double block_distances[kAssignBlockRows];
+  int nearest[kAssignBlockRows];
+  for (int first = 0; first < size; first += kAssignBlockRows) {
+    size_t rows = std::min<size_t>(kAssignBlockRows, size - first);
+    for (size_t r = 0; r < rows; r++) {
+      int point = members[first + r];
+      std::copy_n(points_->Row(point), num_of_dimensions, block.Row(r));
+      block_norms[r] = (*squared_norms_points_)[point];
+    }
+    AssignBlock(block.Data(), stride, block_norms, rows,
+                partial.packed_candidates_, nearest, block_distances);
+
+    for (size_t r = 0; r < rows; r++) {
+      AccumulatePoint(*points_, members[first + r], candidates[nearest[r]],
+                      block_distances[r], state.labels_, partial);
+    }
+  }
+}
@@ -0,0 +1,414 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+/*
+Triangle inequality accelerated assignment (Hamerly 2010, Elkan 2003)
+
+Both keep, for every point, lower bounds on its distance to the centroids it
+is not assigned to. After the centroids move, a bound is loosened by how far
+the centroid moved, so it stays valid without recomputing anything. A point
+only needs a full search when the distance to its own centroid is larger than
+its bound or larger than half the distance from its centroid to the nearest
+other centroid.
+
+The distance from each point to its own centroid is recomputed exactly every
+iteration. That costs one distance per point, keeps the upper bound tight and
+gives the exact SSE and worst point that the Lloyd loop relies on.
+
+Hamerly keeps one lower bound per point (distance to the second closest
+centroid), which suits small k. Elkan keeps one per point per centroid and
+also prunes individual centroids using the inter-centroid distances, which
+pays off for moderate k.
+
+Yinyang (Ding et al. 2015) sits in between: the centroids are split once per
+run into about k/10 groups by clustering the initial centroids, and every
+point keeps one lower bound per group. A group whose bound is above the
+upper bound is skipped whole, the others are searched centroid by centroid.
+Memory is n * k/10 doubles rather than Elkan's n * k.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "./k_means.h"
+
+void K_Means::UpdateCentroidBounds(RunState& state) {
+  const Kernels& kernels = GetKernels();
+  size_t stride = state.centroids_.Stride();
+  size_t k = num_of_clusters_;
+
+  // how far every centroid moved since the previous assignment
+  state.drifts_.assign(k, 0.0);
+  state.max_drift_ = 0.0;
+  state.second_max_drift_ = 0.0;
+  state.max_drift_cluster_ = -1;
+  if (state.bounds_valid_) {
+    for (size_t c = 0; c < k; c++) {
+      double drift = std::sqrt(kernels.squared_distance_(
+          state.previous_centroids_.Row(c), state.centroids_.Row(c), stride));
+      state.drifts_[c] = drift;
+
+      if (drift > state.max_drift_) {
+        state.second_max_drift_ = state.max_drift_;
+        state.max_drift_ = drift;
+        state.max_drift_cluster_ = static_cast<int>(c);
+      } else if (drift > state.second_max_drift_) {
+        state.second_max_drift_ = drift;
+      }
+    }
+  }
+  state.previous_centroids_ = state.centroids_;
+
+  // half the distance from each centroid to its nearest neighbour, a point
+  // closer than that to its centroid cannot be closer to any other
+  state.centroid_distances_.resize(k * k);
+  state.half_separations_.assign(k, std::numeric_limits<double>::max());
+  for (size_t a = 0; a < k; a++) {
+    state.centroid_distances_[a * k + a] = 0.0;
+    for (size_t b = a + 1; b < k; b++) {
+      double dist = std::sqrt(kernels.squared_distance_(
+          state.centroids_.Row(a), state.centroids_.Row(b), stride));
+      state.centroid_distances_[a * k + b] = dist;
+      state.centroid_distances_[b * k + a] = dist;
+      state.half_separations_[a] =
+          std::min(state.half_separations_[a], dist / 2);
+      state.half_separations_[b] =
+          std::min(state.half_separations_[b], dist / 2);
+    }
+  }
+
+  if (algorithm_ == Algorithm::YINYANG) {
+    if (!state.bounds_valid_) GroupCentroids(state);
+
+    state.group_drifts_.assign(state.groups_.size(), 0.0);
+    for (size_t c = 0; c < k; c++) {
+      double& group_drift = state.group_drifts_[state.group_of_cluster_[c]];
+      group_drift = std::max(group_drift, state.drifts_[c]);
+    }
+  }
+
+  if (!state.bounds_valid_) {
+    state.lower_bounds_.assign(num_of_points_ * BoundsPerPoint(state), 0.0);
+  }
+}
+
+size_t K_Means::BoundsPerPoint(const RunState& state) {
+  if (algorithm_ == Algorithm::ELKAN) return num_of_clusters_;
+  if (algorithm_ == Algorithm::YINYANG) return state.groups_.size();
+  return 1;
+}
+
+void K_Means::AssignPointsInRangeHamerly(RunState& state, size_t begin,
+                                         size_t end, PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  size_t stride = points_->Stride();
+  const Matrix& centroids = state.centroids_;
+
+  ResetPartialSums(partial);
+
+  for (size_t i = begin; i < end; i++) {
+    const double* point = points_->Row(i);
+    int assigned = state.labels_[i];
+
+    if (state.bounds_valid_) {
+      // the bound covers every other centroid, so it shrinks by the largest
+      // drift among them
+      double drift = assigned == state.max_drift_cluster_
+                         ? state.second_max_drift_
+                         : state.max_drift_;
+      state.lower_bounds_[i] = std::max(0.0, state.lower_bounds_[i] - drift);
+
+      double squared_distance =
+          kernels.squared_distance_(point, centroids.Row(assigned), stride);
+      partial.num_of_distances_++;
+
+      double upper = std::sqrt(squared_distance);
+      if (upper <= std::max(state.half_separations_[assigned],
+                            state.lower_bounds_[i])) {
+        AccumulatePoint(*points_, i, assigned, squared_distance,
+                        state.labels_, partial);
+        continue;
+      }
+    }
+
+    // full search, remembering the runner up as the new lower bound
+    double lowest = std::numeric_limits<double>::max();
+    double second_lowest = std::numeric_limits<double>::max();
+    int nearest = 0;
+    for (int c = 0; c < num_of_clusters_; c++) {
+      double dist = kernels.squared_distance_(point, centroids.Row(c), stride);
+      if (dist < lowest) {
+        second_lowest = lowest;
+        lowest = dist;
+        nearest = c;
+      } else if (dist < second_lowest) {
+        second_lowest = dist;
+      }
+    }
+    partial.num_of_distances_ += num_of_clusters_;
+
+    state.lower_bounds_[i] = std::sqrt(second_lowest);
+    AccumulatePoint(*points_, i, nearest, lowest, state.labels_, partial);
+  }
+}
+
+void K_Means::AssignPointsInRangeElkan(RunState& state, size_t begin,
+                                       size_t end, PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  size_t stride = points_->Stride();
+  size_t k = num_of_clusters_;
+  const Matrix& centroids = state.centroids_;
+
+  ResetPartialSums(partial);
+
+  for (size_t i = begin; i < end; i++) {
+    const double* point = points_->Row(i);
+    double* lower = &state.lower_bounds_[i * k];
+
+    if (!state.bounds_valid_) {
+      double lowest = std::numeric_limits<double>::max();
+      int nearest = 0;
+      for (size_t c = 0; c < k; c++) {
+        double dist =
+            kernels.squared_distance_(point, centroids.Row(c), stride);
+        lower[c] = std::sqrt(dist);
+        if (dist < lowest) {
+          lowest = dist;
+          nearest = static_cast<int>(c);
+        }
+      }
+      partial.num_of_distances_ += k;
+
+      AccumulatePoint(*points_, i, nearest, lowest, state.labels_, partial);
+      continue;
+    }
+
+    for (size_t c = 0; c < k; c++) {
+      lower[c] = std::max(0.0, lower[c] - state.drifts_[c]);
+    }
+
+    int assigned = state.labels_[i];
+    double squared_distance =
+        kernels.squared_distance_(point, centroids.Row(assigned), stride);
+    partial.num_of_distances_++;
+    double upper = std::sqrt(squared_distance);
+    lower[assigned] = upper;
+
+    if (upper > state.half_separations_[assigned]) {
+      for (size_t c = 0; c < k; c++) {
+        if (static_cast<int>(c) == assigned) continue;
+        // c cannot be closer than the current centroid
+        if (upper <= lower[c] ||
+            upper <= state.centroid_distances_[assigned * k + c] / 2) {
+          continue;
+        }
+
+        double dist =
+            kernels.squared_distance_(point, centroids.Row(c), stride);
+        partial.num_of_distances_++;
+        lower[c] = std::sqrt(dist);
+
+        // ties go to the lower index like the Lloyd scan
+        if (dist < squared_distance ||
+            (dist == squared_distance && static_cast<int>(c) < assigned)) {
+          assigned = static_cast<int>(c);
+          squared_distance = dist;
+          upper = lower[c];
+        }
+      }
+    }
+
+    AccumulatePoint(*points_, i, assigned, squared_distance, state.labels_,
+                    partial);
+  }
+}
+
+void K_Means::GroupCentroids(RunState& state) {
+  const Kernels& kernels = GetKernels();
+  const Matrix& centroids = state.centroids_;
+  size_t stride = centroids.Stride();
+  size_t k = num_of_clusters_;
+  size_t num_of_groups = std::max<size_t>(1, (k + 9) / 10);
+
+  // a few rounds of k-means over the centroids themselves, seeded with evenly
+  // spaced centroids so the grouping is deterministic for a given run
+  Matrix group_centers(num_of_groups, centroids.Cols());
+  for (size_t g = 0; g < num_of_groups; g++) {
+    std::copy(centroids.Row(g * k / num_of_groups),
+              centroids.Row(g * k / num_of_groups) + stride,
+              group_centers.Row(g));
+  }
+
+  state.group_of_cluster_.assign(k, 0);
+  for (int round = 0; round < 5; round++) {
+    for (size_t c = 0; c < k; c++) {
+      double lowest = std::numeric_limits<double>::max();
+      for (size_t g = 0; g < num_of_groups; g++) {
+        double dist = kernels.squared_distance_(centroids.Row(c),
+                                                group_centers.Row(g), stride);
+        if (dist < lowest) {
+          lowest = dist;
+          state.group_of_cluster_[c] = static_cast<int>(g);
+        }
+      }
+    }
+
+    std::vector<int> counts(num_of_groups, 0);
+    Matrix sums(num_of_groups, centroids.Cols());
+    for (size_t c = 0; c < k; c++) {
+      int g = state.group_of_cluster_[c];
+      counts[g]++;
+      for (size_t j = 0; j < centroids.Cols(); j++) {
+        sums.Row(g)[j] += centroids.Row(c)[j];
+      }
+    }
+    for (size_t g = 0; g < num_of_groups; g++) {
+      if (counts[g] == 0) continue;  // keep the old center
+      for (size_t j = 0; j < centroids.Cols(); j++) {
+        group_centers.Row(g)[j] = sums.Row(g)[j] / counts[g];
+      }
+    }
+  }
+
+  // drop groups that ended up empty and renumber the rest
+  std::vector<std::vector<int>> groups(num_of_groups);
+  for (size_t c = 0; c < k; c++) {
+    groups[state.group_of_cluster_[c]].push_back(static_cast<int>(c));
+  }
+  state.groups_.clear();
+  for (size_t g = 0; g < num_of_groups; g++) {
+    if (groups[g].empty()) continue;
+    for (size_t m = 0; m < groups[g].size(); m++) {
+      state.group_of_cluster_[groups[g][m]] =
+          static_cast<int>(state.groups_.size());
+    }
+    state.groups_.push_back(groups[g]);
+  }
+}
+
+void K_Means::AssignPointsInRangeYinyang(RunState& state, size_t begin,
+                                         size_t end, PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  size_t stride = points_->Stride();
+  size_t num_of_groups = state.groups_.size();
+  const Matrix& centroids = state.centroids_;
+
+  ResetPartialSums(partial);
+
+  for (size_t i = begin; i < end; i++) {
+    const double* point = points_->Row(i);
+    // lower[g] bounds the distance to every centroid of group g except the
+    // one the point is assigned to
+    double* lower = &state.lower_bounds_[i * num_of_groups];
+
+    if (!state.bounds_valid_) {
+      std::vector<double>& dists = partial.distances_;
+      dists.resize(num_of_clusters_);
+      double lowest = std::numeric_limits<double>::max();
+      int nearest = 0;
+      for (int c = 0; c < num_of_clusters_; c++) {
+        dists[c] = kernels.squared_distance_(point, centroids.Row(c), stride);
+        if (dists[c] < lowest) {
+          lowest = dists[c];
+          nearest = c;
+        }
+      }
+      partial.num_of_distances_ += num_of_clusters_;
+
+      std::fill(lower, lower + num_of_groups,
+                std::numeric_limits<double>::max());
+      for (int c = 0; c < num_of_clusters_; c++) {
+        if (c == nearest) continue;
+        double& bound = lower[state.group_of_cluster_[c]];
+        bound = std::min(bound, std::sqrt(dists[c]));
+      }
+
+      AccumulatePoint(*points_, i, nearest, lowest, state.labels_, partial);
+      continue;
+    }
+
+    double global_lower = std::numeric_limits<double>::max();
+    for (size_t g = 0; g < num_of_groups; g++) {
+      lower[g] = std::max(0.0, lower[g] - state.group_drifts_[g]);
+      global_lower = std::min(global_lower, lower[g]);
+    }
+
+    int assigned = state.labels_[i];
+    double squared_distance =
+        kernels.squared_distance_(point, centroids.Row(assigned), stride);
+    partial.num_of_distances_++;
+    double upper = std::sqrt(squared_distance);
+
+    // global filter, no group can hold a closer centroid
+    if (upper <= std::max(global_lower, state.half_separations_[assigned])) {
+      AccumulatePoint(*points_, i, assigned, squared_distance,
+                      state.labels_, partial);
+      continue;
+    }
+
+    // group filter
+    for (size_t g = 0; g < num_of_groups; g++) {
+      if (upper <= lower[g]) continue;
+
+      double best = std::numeric_limits<double>::max();
+      double second = std::numeric_limits<double>::max();
+      int best_cluster = -1;
+      const std::vector<int>& members = state.groups_[g];
+      for (size_t m = 0; m < members.size(); m++) {
+        int c = members[m];
+        if (c == assigned) continue;
+
+        double dist =
+            kernels.squared_distance_(point, centroids.Row(c), stride);
+        partial.num_of_distances_++;
+        if (dist < best) {
+          second = best;
+          best = dist;
+          best_cluster = c;
+        } else if (dist < second) {
+          second = dist;
+        }
+      }
+      if (best_cluster == -1) continue;  // group only held the assigned one
+
+      // ties go to the lower index like the Lloyd scan
+      if (best < squared_distance ||
+          (best == squared_distance && best_cluster < assigned)) {
+        // the old centroid becomes one of the "other" centroids of its group
+        int old_group = state.group_of_cluster_[assigned];
+        if (old_group == static_cast<int>(g)) {
+          lower[g] = std::min(std::sqrt(second), upper);
+        } else {
+          lower[old_group] = std::min(lower[old_group], upper);
+          lower[g] = std::sqrt(second);
+        }
+        assigned = best_cluster;
+        squared_distance = best;
+        upper = std::sqrt(best);
+      } else {
+        lower[g] = std::sqrt(best);
+      }
+    }
+
+    AccumulatePoint(*points_, i, assigned, squared_distance, state.labels_,
+                    partial);
+  }
+}
+
+void K_Means::InvalidateBounds(RunState& state, int point) {
+  // the filtering engine no longer knows which cells share one label
+  if (algorithm_ == Algorithm::FILTERING) {
+    state.cell_labels_.assign(state.cell_labels_.size(), kMixedCell);
+    return;
+  }
+  if (!UsesBounds() || state.lower_bounds_.empty()) return;
+
+  // the point changed cluster outside of an assignment pass, zero bounds
+  // force a full search for it next iteration
+  size_t bounds_per_point = BoundsPerPoint(state);
+  std::fill(state.lower_bounds_.begin() + point * bounds_per_point,
+            state.lower_bounds_.begin() + (point + 1) * bounds_per_point, 0.0);
+}
@@ -0,0 +1,305 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+/*
+KD-tree filtering assignment (Kanungo et al. 2002)
+
+The tree over the normalized points is built once per Data, so every restart
+and every k of the validation sweep walk the same tree. Each pass starts at
+the top with every centroid as a candidate. In a cell, z* is the candidate
+closest to the cell's midpoint. Any other candidate z that is no closer than
+z* to the corner of the cell's box furthest in the direction z - z* is no
+closer than z* to any point of the cell, so it is dropped for the whole
+subtree. Once z* is the only candidate left the cell is assigned whole:
+
+  - its SSE comes from the cell's sum and summed squared norm,
+  - if every point of the cell already had one label the cluster sums move
+    by the cell's sum, otherwise only the points that changed are visited,
+  - if every point already had z* as its label nothing else happens.
+
+Leaves that still hold several candidates score their points one by one
+against the survivors only.
+
+Points of whole cells are never scored, so the worst point of a cluster is
+only known for points scored in leaves. It is recomputed exactly, in one
+pass over the points, when a cluster is down to one point and singleton
+repair needs it.
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "./k_means.h"
+
+void K_Means::FindFrontier(RunState& state, size_t num_of_cells) {
+  // split the top of the tree a level at a time until there are enough
+  // cells to spread over the workers, parents go into above_frontier_
+  // before their children
+  state.frontier_.assign(1, 0);
+  state.above_frontier_.clear();
+  while (state.frontier_.size() < num_of_cells) {
+    bool split = false;
+    size_t size = state.frontier_.size();
+    for (size_t f = 0; f < size; f++) {
+      int node = state.frontier_[f];
+      const KdTree::Node& cell = kd_tree_->GetNode(node);
+      if (cell.left_ == -1) continue;
+
+      state.above_frontier_.push_back(node);
+      state.frontier_[f] = cell.left_;
+      state.frontier_.push_back(cell.right_);
+      split = true;
+    }
+    if (!split) break;
+  }
+}
+
+void K_Means::FilterPoints(RunState& state, ThreadPool* pool) {
+  // a few cells per worker so uneven cells still balance
+  if (state.frontier_.empty()) {
+    int num_of_threads = pool != nullptr ? pool->GetNumOfThreads() : 1;
+    FindFrontier(state, num_of_threads > 1 ? 4 * num_of_threads : 1);
+  }
+
+  // the nodes above the frontier are not visited, a label they share is
+  // handed down to the frontier first
+  for (int node : state.above_frontier_) {
+    int& label = state.cell_labels_[node];
+    if (label == kMixedCell) continue;
+
+    const KdTree::Node& cell = kd_tree_->GetNode(node);
+    state.cell_labels_[cell.left_] = label;
+    state.cell_labels_[cell.right_] = label;
+    label = kMixedCell;
+  }
+
+  auto filter_range = [this, &state](size_t begin, size_t end,
+                                     PartialSums& partial) {
+    ResetPartialSums(partial);
+    std::vector<int>& candidates = partial.candidates_;
+    if (candidates.size() < static_cast<size_t>(num_of_clusters_)) {
+      candidates.resize(num_of_clusters_);
+    }
+    for (int c = 0; c < num_of_clusters_; c++) candidates[c] = c;
+
+    for (size_t f = begin; f < end; f++) {
+      FilterCell(state, state.frontier_[f], 0, num_of_clusters_, partial);
+    }
+  };
+
+  if (pool != nullptr) {
+    pool->ParallelFor(state.frontier_.size(),
+                      [&state, &filter_range](size_t begin, size_t end,
+                                              int worker) {
+                        filter_range(begin, end, state.partial_sums_[worker]);
+                      });
+  } else {
+    filter_range(0, state.frontier_.size(), state.partial_sums_[0]);
+  }
+
+  // and collected back up, children before parents
+  for (auto it = state.above_frontier_.rbegin();
+       it != state.above_frontier_.rend(); ++it) {
+    const KdTree::Node& cell = kd_tree_->GetNode(*it);
+    if (state.cell_labels_[cell.left_] == state.cell_labels_[cell.right_]) {
+      state.cell_labels_[*it] = state.cell_labels_[cell.left_];
+    }
+  }
+}
+
+// candidates_[offset, offset + count) are the centroids still possible for
+// the cell, the survivors for its children are written right after them
+void K_Means::FilterCell(RunState& state, int node, size_t offset, int count,
+                         PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  const KdTree::Node& cell = kd_tree_->GetNode(node);
+  const Matrix& centroids = state.centroids_;
+  size_t num_of_dimensions = points_->Cols();
+  size_t stride = centroids.Stride();
+  std::vector<int>& candidates = partial.candidates_;
+
+  if (cell.left_ == -1) {
+    const std::vector<int>& indices = kd_tree_->Indices();
+    int shared_label = -1;
+    for (int i = cell.begin_; i < cell.end_; i++) {
+      int point = indices[i];
+      const double* row = kd_tree_->Points().Row(i);
+
+      // nothing pruned, score the point the way the Lloyd loop does.
+      // Otherwise candidates are in index order, so ties still go to the
+      // lowest index
+      int nearest = candidates[offset];
+      double lowest_distance = std::numeric_limits<double>::max();
+      if (count == num_of_clusters_) {
+        nearest = kernels.nearest_centroid_(
+            row, (*squared_norms_points_)[point], centroids.Data(),
+            state.squared_norms_centroids_.data(), count, stride, stride,
+            &lowest_distance);
+      } else {
+        for (int c = 0; c < count; c++) {
+          int candidate = candidates[offset + c];
+          double distance = kernels.squared_distance_(
+              row, centroids.Row(candidate), stride);
+          if (distance < lowest_distance) {
+            lowest_distance = distance;
+            nearest = candidate;
+          }
+        }
+      }
+      AccumulatePoint(*points_, point, nearest, lowest_distance,
+                      state.labels_, partial);
+
+      if (i == cell.begin_) {
+        shared_label = nearest;
+      } else if (nearest != shared_label) {
+        shared_label = kMixedCell;
+      }
+    }
+    partial.num_of_distances_ +=
+        static_cast<long long>(cell.end_ - cell.begin_) * count;
+    state.cell_labels_[node] = shared_label;
+    return;
+  }
+
+  const double* lower = kd_tree_->Lower(node);
+  const double* upper = kd_tree_->Upper(node);
+
+  // padding past the last dimension stays zero like the centroid rows
+  std::vector<double>& midpoint = partial.midpoint_;
+  midpoint.resize(stride, 0.0);
+  for (size_t j = 0; j < num_of_dimensions; j++) {
+    midpoint[j] = (lower[j] + upper[j]) / 2;
+  }
+
+  int closest = candidates[offset];
+  double closest_distance = std::numeric_limits<double>::max();
+  for (int c = 0; c < count; c++) {
+    int candidate = candidates[offset + c];
+    double distance = kernels.squared_distance_(
+        midpoint.data(), centroids.Row(candidate), stride);
+    if (distance < closest_distance) {
+      closest_distance = distance;
+      closest = candidate;
+    }
+  }
+
+  size_t next = offset + count;
+  if (candidates.size() < next + count) candidates.resize(next + count);
+
+  // a candidate no closer than closest to the box corner furthest in its
+  // direction is no closer to any point of the cell
+  const double* best = centroids.Row(closest);
+  int survivors = 0;
+  for (int c = 0; c < count; c++) {
+    int candidate = candidates[offset + c];
+    if (candidate != closest) {
+      const double* centroid = centroids.Row(candidate);
+      double to_candidate = 0.0;
+      double to_closest = 0.0;
+      for (size_t j = 0; j < num_of_dimensions; j++) {
+        double corner = centroid[j] > best[j] ? upper[j] : lower[j];
+        to_candidate += (centroid[j] - corner) * (centroid[j] - corner);
+        to_closest += (best[j] - corner) * (best[j] - corner);
+      }
+      if (to_candidate >= to_closest) continue;
+    }
+    candidates[next + survivors++] = candidate;
+  }
+  partial.num_of_distances_ += 2 * count - 1;
+
+  if (survivors == 1) {
+    AssignCell(state, node, closest, partial);
+    return;
+  }
+
+  // a label shared by the whole cell becomes the label of both halves
+  if (state.cell_labels_[node] != kMixedCell) {
+    state.cell_labels_[cell.left_] = state.cell_labels_[node];
+    state.cell_labels_[cell.right_] = state.cell_labels_[node];
+  }
+  FilterCell(state, cell.left_, next, survivors, partial);
+  FilterCell(state, cell.right_, next, survivors, partial);
+
+  int left_label = state.cell_labels_[cell.left_];
+  state.cell_labels_[node] =
+      left_label == state.cell_labels_[cell.right_] ? left_label : kMixedCell;
+}
+
+void K_Means::AssignCell(RunState& state, int node, int centroid,
+                         PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  const KdTree::Node& cell = kd_tree_->GetNode(node);
+  size_t num_of_dimensions = points_->Cols();
+  int size = cell.end_ - cell.begin_;
+  const double* cell_sum = kd_tree_->Sum(node);
+
+  // sum of ||x - c||^2 over the cell = sum ||x||^2 - 2 c.sum x + n ||c||^2
+  double sse = cell.squared_norm_sum_ -
+               2 * kernels.dot_product_(state.centroids_.Row(centroid),
+                                        cell_sum, kd_tree_->Stride()) +
+               size * state.squared_norms_centroids_[centroid];
+  partial.sse_ += std::max(sse, 0.0);
+
+  int& label = state.cell_labels_[node];
+  if (label == centroid) return;
+
+  const std::vector<int>& indices = kd_tree_->Indices();
+  if (label == kMixedCell) {
+    // a zero distance leaves the SSE and the worst point alone
+    for (int i = cell.begin_; i < cell.end_; i++) {
+      AccumulatePoint(*points_, indices[i], centroid, 0.0, state.labels_,
+                      partial);
+    }
+  } else {
+    // every point comes from the same cluster (none on the first pass), the
+    // whole cell moves at once
+    double* sum = &partial.sums_[centroid * num_of_dimensions];
+    for (size_t j = 0; j < num_of_dimensions; j++) {
+      sum[j] += cell_sum[j];
+    }
+    partial.counts_[centroid] += size;
+
+    if (label != -1) {
+      double* previous_sum = &partial.sums_[label * num_of_dimensions];
+      for (size_t j = 0; j < num_of_dimensions; j++) {
+        previous_sum[j] -= cell_sum[j];
+      }
+      partial.counts_[label] -= size;
+      partial.points_moved_ += size;
+    }
+
+    for (int i = cell.begin_; i < cell.end_; i++) {
+      state.labels_[indices[i]] = centroid;
+    }
+  }
+  label = centroid;
+}
+
+void K_Means::RefreshWorstDistances(RunState& state) {
+  bool singleton = false;
+  for (const Cluster& cluster : state.clusters_) {
+    if (cluster.num_of_points_ <= 1) singleton = true;
+  }
+  if (!singleton) return;
+
+  const Kernels& kernels = GetKernels();
+  size_t stride = state.centroids_.Stride();
+  for (Cluster& cluster : state.clusters_) {
+    cluster.worst_distance_ = 0.0;
+    cluster.pos_of_worst_point_ = -1;
+  }
+
+  for (int i = 0; i < num_of_points_; i++) {
+    int c = state.labels_[i];
+    double distance = kernels.squared_distance_(
+        points_->Row(i), state.centroids_.Row(c), stride);
+    Cluster& cluster = state.clusters_[c];
+    if (distance > cluster.worst_distance_) {
+      cluster.worst_distance_ = distance;
+      cluster.pos_of_worst_point_ = i;
+    }
+  }
+  state.num_of_distance_evaluations_ += num_of_points_;
+}
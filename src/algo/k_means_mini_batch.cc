@@ -0,0 +1,143 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+/*
+Mini-batch k-means (Sculley 2010)
+
+Each iteration samples batch_size_ points, assigns them to the current
+centroids and moves every centroid towards its sampled points with a
+learning rate of 1 / (points it has absorbed so far), so each centroid
+stays the running mean of everything assigned to it. One iteration touches
+batch_size_ points instead of all n.
+
+The run stops when an exponentially weighted average of the mean squared
+centroid movement falls under MINI_BATCH_TOLERANCE, or after the dataset's
+max iterations. A single full assignment pass at the start and one at the
+end give the initial and final SSE, labels and cluster sums, so the results
+are reported the same way as a Lloyd run. The profile counts each batch as
+one iteration, the two full passes go with the first and the last batch.
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include "./k_means.h"
+
+void K_Means::RunMiniBatch(RunState& state, ThreadPool* pool) {
+  const Kernels& kernels = GetKernels();
+  RunProfile& profile = state.profile_;
+  size_t num_of_dimensions = points_->Cols();
+  size_t stride = points_->Stride();
+  int batch_size = std::min(std::max(batch_size_, 1), num_of_points_);
+  int max_iterations = std::max(data_->GetMaxIterations(), 1);
+
+  // the full pass is counted with the first batch
+  uint64_t allocations_before = CountAllocations(pool);
+  long long distances_before = state.num_of_distance_evaluations_;
+  {
+    ScopedTimer timer(profile, Phase::ASSIGNMENT, 1);
+    state.initial_sse_ = AssignPointsToClusters(state, pool);
+  }
+  state.centroids_.Resize(num_of_clusters_, num_of_dimensions);
+  for (int c = 0; c < num_of_clusters_; c++) {
+    const std::vector<double>& centroid = state.clusters_[c].centroid_;
+    std::copy(centroid.begin(), centroid.end(), state.centroids_.Row(c));
+  }
+
+  std::uniform_int_distribution<> distrib(0, num_of_points_ - 1);
+  std::vector<int> batch(batch_size);
+  std::vector<int> batch_labels(batch_size);
+  std::vector<long long> absorbed(num_of_clusters_, 0);
+  Matrix previous_centroids;
+
+  // weight of the newest batch in the moving average, larger batches see
+  // more of the data so their movement is trusted more
+  double alpha = std::min(1.0, 2.0 * batch_size / (num_of_points_ + 1.0));
+  double smoothed_movement = -1.0;
+
+  for (int iter = 0; iter < max_iterations; iter++) {
+    int iteration = iter + 1;
+    if (iter > 0) allocations_before = CountAllocations(pool);
+    bool converged;
+    {
+      ScopedTimer timer(profile, Phase::MINI_BATCH, iteration);
+      for (int b = 0; b < batch_size; b++) {
+        batch[b] = distrib(state.gen_);
+      }
+
+      state.squared_norms_centroids_.resize(num_of_clusters_);
+      for (int c = 0; c < num_of_clusters_; c++) {
+        state.squared_norms_centroids_[c] = kernels.dot_product_(
+            state.centroids_.Row(c), state.centroids_.Row(c), stride);
+      }
+
+      // assign the whole batch against the same centroids before moving any
+      for (int b = 0; b < batch_size; b++) {
+        double distance;
+        batch_labels[b] = kernels.nearest_centroid_(
+            points_->Row(batch[b]), (*squared_norms_points_)[batch[b]],
+            state.centroids_.Data(), state.squared_norms_centroids_.data(),
+            num_of_clusters_, stride, stride, &distance);
+      }
+      state.num_of_distance_evaluations_ +=
+          static_cast<long long>(batch_size) * num_of_clusters_;
+
+      previous_centroids = state.centroids_;
+      for (int b = 0; b < batch_size; b++) {
+        int c = batch_labels[b];
+        absorbed[c]++;
+        double learning_rate = 1.0 / static_cast<double>(absorbed[c]);
+
+        double* centroid = state.centroids_.Row(c);
+        const double* point = points_->Row(batch[b]);
+        for (size_t j = 0; j < num_of_dimensions; j++) {
+          centroid[j] += learning_rate * (point[j] - centroid[j]);
+        }
+      }
+
+      double movement = 0.0;
+      for (int c = 0; c < num_of_clusters_; c++) {
+        movement += kernels.squared_distance_(previous_centroids.Row(c),
+                                              state.centroids_.Row(c), stride);
+      }
+      movement /= num_of_clusters_;
+
+      if (smoothed_movement < 0.0) {
+        smoothed_movement = movement;
+      } else {
+        smoothed_movement =
+            alpha * movement + (1 - alpha) * smoothed_movement;
+      }
+      converged = smoothed_movement <= MINI_BATCH_TOLERANCE;
+    }
+
+#if VERBOSE_OUTPUT
+    std::cout << "Batch " << iteration
+              << ": smoothed movement = " << smoothed_movement << std::endl;
+#endif
+
+    if (converged) state.num_of_iterations_ = iteration;
+    bool last = converged || iteration == max_iterations;
+
+    // full pass so labels, sums and the SSE describe the final centroids, it
+    // is counted with the last batch
+    if (last) {
+      for (int c = 0; c < num_of_clusters_; c++) {
+        std::span<const double> centroid = state.centroids_[c];
+        state.clusters_[c].centroid_.assign(centroid.begin(), centroid.end());
+        state.clusters_[c].squared_norm_ = CalculateSquaredNorm(centroid);
+      }
+      ScopedTimer timer(profile, Phase::ASSIGNMENT, iteration);
+      state.sse_ = AssignPointsToClusters(state, pool);
+    }
+
+    profile.RecordCounter(
+        Counter::DISTANCE_EVALUATIONS, iteration,
+        state.num_of_distance_evaluations_ - distances_before);
+    distances_before = state.num_of_distance_evaluations_;
+    RecordAllocations(state, pool, iteration, allocations_before);
+    if (last) break;
+  }
+}
@@ -0,0 +1,294 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./out_of_core_k_means.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <utility>
+
+#include "../util/kernels.h"
+
+OutOfCoreKMeans::OutOfCoreKMeans(const std::string& path, int num_of_clusters,
+                                 int max_iterations,
+                                 double convergence_threshold,
+                                 NormalizationMethod normalization_method,
+                                 int num_of_threads)
+    : reader_(path),
+      num_of_clusters_(num_of_clusters > 0 ? num_of_clusters
+                                           : reader_.NumOfClusters()),
+      max_iterations_(max_iterations),
+      convergence_threshold_(convergence_threshold),
+      normalization_method_(normalization_method) {
+  num_of_points_ = reader_.NumOfPoints();
+  num_of_dimensions_ = reader_.NumOfDimensions();
+  // same fallback as Data when neither the caller nor the header gives k
+  if (num_of_clusters_ <= 0) {
+    num_of_clusters_ = sqrt(num_of_points_ / 2);
+  }
+  if (num_of_clusters_ <= 0 ||
+      static_cast<size_t>(num_of_clusters_) > num_of_points_) {
+    std::cout << path << ": cannot make " << num_of_clusters_
+              << " clusters of " << num_of_points_ << " points" << std::endl;
+    std::exit(1);
+  }
+
+  thread_pool_ = std::make_unique<ThreadPool>(num_of_threads);
+  partial_sums_.resize(thread_pool_->GetNumOfThreads());
+
+  size_t chunk_rows =
+      std::min<size_t>(OUT_OF_CORE_CHUNK_ROWS, num_of_points_);
+  for (Matrix& chunk : chunks_) chunk.Resize(chunk_rows, num_of_dimensions_);
+  chunk_norms_.resize(chunk_rows);
+}
+
+template <typename Fn>
+void OutOfCoreKMeans::ForEachChunk(Fn&& fn) {
+  reader_.Rewind();
+  size_t rows = reader_.Read(chunks_[0]);
+  Normalize(chunks_[0], rows);
+
+  size_t first_row = 0;
+  int current = 0;
+  while (rows > 0) {
+    Matrix& next = chunks_[1 - current];
+    size_t next_rows = 0;
+    std::future<void> read_ahead =
+        reader_pool_.Submit([this, &next, &next_rows] {
+          next_rows = reader_.Read(next);
+          Normalize(next, next_rows);
+        });
+
+    fn(chunks_[current], rows, first_row);
+
+    read_ahead.get();
+    first_row += rows;
+    rows = next_rows;
+    current = 1 - current;
+  }
+}
+
+void OutOfCoreKMeans::Normalize(Matrix& chunk, size_t rows) {
+  if (!normalizes_) return;
+  for (size_t i = 0; i < rows; i++) {
+    double* point = chunk.Row(i);
+    for (size_t j = 0; j < num_of_dimensions_; j++) {
+      point[j] = (point[j] - offsets_[j]) / scales_[j];
+    }
+  }
+}
+
+void OutOfCoreKMeans::ScanDataset() {
+  // random selection: k distinct rows by Floyd's algorithm, so nothing the
+  // size of the dataset is allocated
+  std::seed_seq seq{seed_, 0u};
+  std::mt19937 gen(seq);
+  std::vector<size_t> picks;
+  for (size_t j = num_of_points_ - num_of_clusters_; j < num_of_points_;
+       j++) {
+    size_t row = std::uniform_int_distribution<size_t>(0, j)(gen);
+    if (std::find(picks.begin(), picks.end(), row) != picks.end()) row = j;
+    picks.push_back(row);
+  }
+  // centroid c is the row picks[c], captured as the scan passes it
+  std::vector<std::pair<size_t, int>> captures;
+  for (int c = 0; c < num_of_clusters_; c++) captures.push_back({picks[c], c});
+  std::sort(captures.begin(), captures.end());
+
+  centroids_.Resize(num_of_clusters_, num_of_dimensions_);
+  std::vector<double> lowest(num_of_dimensions_,
+                             std::numeric_limits<double>::max());
+  std::vector<double> highest(num_of_dimensions_,
+                              std::numeric_limits<double>::lowest());
+  std::vector<double> means(num_of_dimensions_, 0.0);
+  std::vector<double> squared_deviations(num_of_dimensions_, 0.0);
+  size_t next_capture = 0;
+
+  normalizes_ = false;
+  ForEachChunk([&](const Matrix& chunk, size_t rows, size_t first_row) {
+    for (size_t i = 0; i < rows; i++) {
+      const double* point = chunk.Row(i);
+      double count = static_cast<double>(first_row + i + 1);
+      for (size_t j = 0; j < num_of_dimensions_; j++) {
+        lowest[j] = std::min(lowest[j], point[j]);
+        highest[j] = std::max(highest[j], point[j]);
+        double delta = point[j] - means[j];
+        means[j] += delta / count;
+        squared_deviations[j] += delta * (point[j] - means[j]);
+      }
+
+      while (next_capture < captures.size() &&
+             captures[next_capture].first == first_row + i) {
+        std::copy_n(point, num_of_dimensions_,
+                    centroids_.Row(captures[next_capture].second));
+        next_capture++;
+      }
+    }
+  });
+
+  // the same scaling as MinMaxNormalize and ZScoreNormalize, a file written
+  // already normalized is used as is
+  offsets_.assign(num_of_dimensions_, 0.0);
+  scales_.assign(num_of_dimensions_, 1.0);
+  normalizes_ = reader_.StoredNormalization() != normalization_method_;
+  if (!normalizes_) return;
+
+  for (size_t j = 0; j < num_of_dimensions_; j++) {
+    if (normalization_method_ == NormalizationMethod::MIN_MAX) {
+      offsets_[j] = lowest[j];
+      scales_[j] = std::max(highest[j] - lowest[j], 1e-9);
+    } else {
+      offsets_[j] = means[j];
+      scales_[j] = std::max(std::sqrt(squared_deviations[j]), 1e-9);
+    }
+  }
+  Normalize(centroids_, num_of_clusters_);
+}
+
+void OutOfCoreKMeans::PrepareCentroids() {
+  const Kernels& kernels = GetKernels();
+  size_t stride = centroids_.Stride();
+
+  squared_norms_centroids_.resize(num_of_clusters_);
+  for (int c = 0; c < num_of_clusters_; c++) {
+    squared_norms_centroids_[c] =
+        kernels.dot_product_(centroids_.Row(c), centroids_.Row(c), stride);
+  }
+  if (num_of_clusters_ >= BLOCKED_ASSIGN_MIN_K) {
+    PackCentroids(centroids_, squared_norms_centroids_.data(),
+                  packed_centroids_);
+  }
+}
+
+double OutOfCoreKMeans::AssignPoints() {
+  PrepareCentroids();
+  for (PartialSums& partial : partial_sums_) {
+    partial.sums_.assign(num_of_clusters_ * num_of_dimensions_, 0.0);
+    partial.counts_.assign(num_of_clusters_, 0);
+    partial.sse_ = 0.0;
+  }
+
+  ForEachChunk([this](const Matrix& chunk, size_t rows, size_t first_row) {
+    thread_pool_->ParallelFor(
+        rows, [this, &chunk, first_row](size_t begin, size_t end, int worker) {
+          AssignRange(chunk, begin, end, first_row, partial_sums_[worker]);
+        });
+  });
+  num_of_distance_evaluations_ +=
+      static_cast<long long>(num_of_points_) * num_of_clusters_;
+
+  double sse = 0.0;
+  for (const PartialSums& partial : partial_sums_) sse += partial.sse_;
+  return sse;
+}
+
+void OutOfCoreKMeans::AssignRange(const Matrix& chunk, size_t begin,
+                                  size_t end, size_t first_row,
+                                  PartialSums& partial) {
+  const Kernels& kernels = GetKernels();
+  size_t stride = chunk.Stride();
+
+  for (size_t i = begin; i < end; i++) {
+    chunk_norms_[i] = kernels.dot_product_(chunk.Row(i), chunk.Row(i), stride);
+  }
+
+  // labels go to the partial sums and, when kept, the label array
+  auto accumulate = [&](size_t i, int centroid, double distance) {
+    const double* point = chunk.Row(i);
+    double* sum = &partial.sums_[centroid * num_of_dimensions_];
+    for (size_t j = 0; j < num_of_dimensions_; j++) sum[j] += point[j];
+    partial.counts_[centroid]++;
+    // the norm expansion can round slightly below zero
+    partial.sse_ += std::max(distance, 0.0);
+    if (keep_labels_) labels_[first_row + i] = centroid;
+  };
+
+  if (num_of_clusters_ >= BLOCKED_ASSIGN_MIN_K) {
+    double distances[kAssignBlockRows];
+    int nearest[kAssignBlockRows];
+    for (size_t block = begin; block < end; block += kAssignBlockRows) {
+      size_t rows = std::min(kAssignBlockRows, end - block);
+      AssignBlock(chunk.Row(block), stride, &chunk_norms_[block], rows,
+                  packed_centroids_, nearest, distances);
+      for (size_t r = 0; r < rows; r++) {
+        accumulate(block + r, nearest[r], distances[r]);
+      }
+    }
+    return;
+  }
+
+  for (size_t i = begin; i < end; i++) {
+    double distance;
+    int centroid = kernels.nearest_centroid_(
+        chunk.Row(i), chunk_norms_[i], centroids_.Data(),
+        squared_norms_centroids_.data(), num_of_clusters_, stride, stride,
+        &distance);
+    accumulate(i, centroid, distance);
+  }
+}
+
+void OutOfCoreKMeans::UpdateCentroids() {
+  for (int c = 0; c < num_of_clusters_; c++) {
+    long long count = 0;
+    for (const PartialSums& partial : partial_sums_) {
+      count += partial.counts_[c];
+    }
+    // an empty cluster keeps its centroid
+    if (count == 0) continue;
+
+    double* centroid = centroids_.Row(c);
+    for (size_t j = 0; j < num_of_dimensions_; j++) {
+      double sum = 0.0;
+      for (const PartialSums& partial : partial_sums_) {
+        sum += partial.sums_[c * num_of_dimensions_ + j];
+      }
+      centroid[j] = sum / count;
+    }
+  }
+}
+
+void OutOfCoreKMeans::Run() {
+  num_of_distance_evaluations_ = 0;
+  ScanDataset();
+  if (keep_labels_) {
+    labels_.assign(num_of_points_, -1);
+  } else {
+    labels_.clear();
+  }
+
+  double sse = std::numeric_limits<double>::max();
+  num_of_iterations_ = -1;
+  for (int iter = 0; iter < max_iterations_; iter++) {
+    double new_sse = AssignPoints();
+    if (iter == 0) initial_sse_ = new_sse;
+
+#if VERBOSE_OUTPUT
+    std::cout << "Iteration " << iter + 1 << ": SSE = " << new_sse
+              << std::endl;
+#endif
+
+    // same stopping rule as K_Means, the labels then match the centroids
+    if (convergence_threshold_ >= sse - new_sse) {
+      sse = new_sse;
+      num_of_iterations_ = iter + 1;
+      break;
+    }
+    sse = new_sse;
+    UpdateCentroids();
+  }
+  final_sse_ = sse;
+}
+
+void OutOfCoreKMeans::exportResults(std::ostream& out) {
+  if (normalization_method_ == NormalizationMethod::Z_SCORE) {
+    out << "Z-Score Normalization,";
+  } else if (normalization_method_ == NormalizationMethod::MIN_MAX) {
+    out << "Min-Max Normalization,";
+  }
+  out << "Random Initialization," << initial_sse_ << "," << final_sse_ << ","
+      << num_of_iterations_;
+}
@@ -0,0 +1,120 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef OUT_OF_CORE_K_MEANS_H_
+#define OUT_OF_CORE_K_MEANS_H_
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../data/dataset_io.h"
+#include "../data/matrix.h"
+#include "../util/blocked_assign.h"
+#include "../util/config.h"
+#include "../util/thread_pool.h"
+
+// Lloyd's algorithm over a dataset streamed from disk, for text or binary
+// tables too large for Data to load. Each pass reads the file in blocks of
+// OUT_OF_CORE_CHUNK_ROWS points: a reader thread reads and normalizes the
+// next block while the pool assigns the current one and accumulates the
+// cluster sums. Only the centroids, per-worker sums and, when asked for, the
+// labels stay in memory.
+//
+// A first streaming pass collects the normalization statistics (min / max,
+// or mean and squared deviations with Welford's update) and the rows picked
+// as initial centroids, so a run reads the file max iterations + 1 times at
+// most. Initialization is random selection and there is a single restart,
+// every restart would cost as many more passes over the file.
+class OutOfCoreKMeans {
+ private:
+  DatasetReader reader_;
+  int num_of_clusters_;
+  int max_iterations_;
+  double convergence_threshold_;
+  NormalizationMethod normalization_method_;
+  unsigned int seed_ = 0;
+  bool keep_labels_ = false;
+
+  size_t num_of_points_;
+  size_t num_of_dimensions_;
+
+  // normalized x = (x - offsets_) / scales_, skipped while normalizes_ is
+  // false (the scan, and files that already carry the normalization)
+  bool normalizes_ = false;
+  std::vector<double> offsets_;
+  std::vector<double> scales_;
+
+  Matrix centroids_;
+  std::vector<double> squared_norms_centroids_;
+  PackedCentroids packed_centroids_;
+  std::vector<int> labels_;
+
+  // one per worker, cleared every pass
+  struct PartialSums {
+    std::vector<double> sums_;  // num_of_clusters_ x num_of_dimensions
+    std::vector<long long> counts_;
+    double sse_;
+  };
+  std::vector<PartialSums> partial_sums_;
+
+  // the block being assigned and the block being read ahead
+  Matrix chunks_[2];
+  std::vector<double> chunk_norms_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  // a single thread, so reads stay in file order
+  ThreadPool reader_pool_{1};
+
+  double initial_sse_ = -1.0;
+  double final_sse_ = -1.0;
+  int num_of_iterations_ = -1;  // -1 when the run hit max iterations
+  long long num_of_distance_evaluations_ = 0;
+
+  // reads the file once for the normalization statistics and the initial
+  // centroids
+  void ScanDataset();
+  void Normalize(Matrix& chunk, size_t rows);
+  // calls fn(chunk, rows, first_row) for every block of normalized points in
+  // file order, the next block is read while fn runs
+  template <typename Fn>
+  void ForEachChunk(Fn&& fn);
+  // one assignment pass over the file, returns the SSE
+  double AssignPoints();
+  void AssignRange(const Matrix& chunk, size_t begin, size_t end,
+                   size_t first_row, PartialSums& partial);
+  void UpdateCentroids();
+  void PrepareCentroids();
+
+ public:
+  // num_of_clusters 0 takes k from the dataset header, or sqrt(n / 2) when
+  // the header has none
+  explicit OutOfCoreKMeans(
+      const std::string& path, int num_of_clusters = 0,
+      int max_iterations = 100, double convergence_threshold = 0.001,
+      NormalizationMethod normalization_method = NormalizationMethod::MIN_MAX,
+      int num_of_threads = NUM_OF_THREADS);
+
+  void SetSeed(unsigned int seed) { seed_ = seed; }
+  // keeps one label per point, n ints on top of the centroids
+  void SetKeepLabels(bool keep_labels) { keep_labels_ = keep_labels; }
+
+  void Run();
+  // writes the CSV fields after the dataset name like K_Means
+  void exportResults(std::ostream& out = std::cout);
+
+  const Matrix& GetCentroids() const { return centroids_; }
+  // empty unless SetKeepLabels(true)
+  const std::vector<int>& GetLabels() const { return labels_; }
+  double GetInitialSSE() const { return initial_sse_; }
+  double GetFinalSSE() const { return final_sse_; }
+  int GetNumOfIterations() const { return num_of_iterations_; }
+  long long GetNumOfDistanceEvaluations() const {
+    return num_of_distance_evaluations_;
+  }
+};
+
+#endif  // OUT_OF_CORE_K_MEANS_H_
@@ -0,0 +1,639 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+// Benchmarks the clustering building blocks in isolation and whole K_Means
+// runs over every dataset in a directory. Each result is printed as it is
+// measured and all of them are written as JSON at the end, so runs before and
+// after a change can be compared by script.
+//
+// Micro benchmarks run on synthetic uniform points so their size is fixed:
+//   kernel     squared distance / dot product / nearest centroid per ISA
+//   assign     one full assignment pass, point at a time and blocked
+//   update     cluster sums and centroid means from a labeling
+// Dataset benchmarks run on one real dataset:
+//   init       every initialization method
+//   internal   Silhouette width and Calinski-Harabasz of a finished run
+//   external   Rand / Jaccard / ARI / NMI / Fowlkes-Mallows of two labelings
+// End to end:
+//   run        K_Means::Run per dataset, k, algorithm and thread count, with
+//              the best SSE (Lloyd also in float32) and the heap allocations
+//              its iteration loops made after warming up (expected to be 0)
+//
+// ns_per_point_centroid divides the time by the point x centroid distances
+// computed, gb_per_s is the point data read over the time.
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../algo/k_means.h"
+#include "../data/data.h"
+#include "../data/matrix.h"
+#include "../external_validation/external_val.h"
+#include "../util/blocked_assign.h"
+#include "../util/config.h"
+#include "../util/kernels.h"
+#include "../util/math.h"
+#include "../util/thread_pool.h"
+#include "../validation/validate.h"
+
+namespace {
+
+struct Options {
+  std::string datasets_ = "datasets";
+  std::string dataset_;  // dataset benchmarks, default <datasets>/landsat.txt
+  std::string json_ = "outputs/bench.json";
+  double min_seconds_ = 0.2;  // each measurement repeats for at least this
+  int num_of_runs_ = 5;       // restarts per end to end run
+  int batch_size_ = MINI_BATCH_SIZE;  // points per mini-batch iteration
+  size_t num_of_points_ = 8192;
+  size_t num_of_dimensions_ = 32;
+  bool quick_ = false;
+};
+
+struct Result {
+  std::string group_;
+  std::string name_;
+  // values are already JSON literals
+  std::vector<std::pair<std::string, std::string>> params_;
+  double ns_per_op_;
+  double ns_per_point_centroid_ = -1.0;  // -1 when it does not apply
+  double gb_per_s_ = -1.0;
+};
+
+std::vector<Result> results;
+
+std::string Quote(const std::string& text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') quoted += '\\';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+std::string Number(double value) {
+  std::ostringstream stream;
+  stream.precision(10);
+  stream << value;
+  return stream.str();
+}
+
+// records and prints one measurement
+void Report(Result result) {
+  std::cout << result.group_ << "/" << result.name_;
+  for (const auto& [key, value] : result.params_) {
+    std::cout << " " << key << "=" << value;
+  }
+  std::cout << "  " << Number(result.ns_per_op_) << " ns/op";
+  if (result.ns_per_point_centroid_ >= 0.0) {
+    std::cout << "  " << Number(result.ns_per_point_centroid_)
+              << " ns/point/centroid";
+  }
+  if (result.gb_per_s_ >= 0.0) {
+    std::cout << "  " << Number(result.gb_per_s_) << " GB/s";
+  }
+  std::cout << std::endl;
+  results.push_back(std::move(result));
+}
+
+// average ns per call of fn, repeated until min_seconds have passed
+template <typename Fn>
+double TimeNs(Fn&& fn, double min_seconds) {
+  using Clock = std::chrono::steady_clock;
+  fn();  // warm up caches and lazily built state
+
+  long long reps = 1;
+  while (true) {
+    auto start = Clock::now();
+    for (long long r = 0; r < reps; r++) fn();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start)
+                    .count();
+    if (ns >= min_seconds * 1e9) return ns / static_cast<double>(reps);
+    reps *= 2;
+  }
+}
+
+template <typename T>
+BasicMatrix<T> RandomMatrix(size_t rows, size_t cols, unsigned int seed) {
+  BasicMatrix<T> matrix(rows, cols);
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  for (size_t i = 0; i < rows; i++) {
+    for (size_t j = 0; j < cols; j++) matrix.Row(i)[j] = unit(gen);
+  }
+  return matrix;
+}
+
+template <typename T>
+std::vector<T> SquaredNorms(const BasicMatrix<T>& matrix) {
+  const BasicKernels<T>& kernels = GetKernels<T>();
+  std::vector<T> norms(matrix.Rows());
+  for (size_t i = 0; i < matrix.Rows(); i++) {
+    norms[i] = kernels.dot_product_(matrix.Row(i), matrix.Row(i),
+                                    matrix.Stride());
+  }
+  return norms;
+}
+
+template <typename T>
+const char* TypeName() {
+  return sizeof(T) == sizeof(float) ? "float32" : "float64";
+}
+
+template <typename T>
+void BenchKernels(const Options& options) {
+  constexpr size_t kRows = 1024;
+  std::vector<size_t> dimensions = {4, 16, 64, 256};
+  if (options.quick_) dimensions = {16, 64};
+
+  for (int isa = 0; isa < static_cast<int>(KernelIsa::COUNT); isa++) {
+    const BasicKernels<T>* kernels =
+        GetKernels<T>(static_cast<KernelIsa>(isa));
+    if (kernels == nullptr) continue;
+
+    for (size_t d : dimensions) {
+      BasicMatrix<T> points = RandomMatrix<T>(kRows, d, 1);
+      size_t stride = points.Stride();
+      double bytes = 2.0 * kRows * stride * sizeof(T);
+      volatile double sink = 0.0;
+
+      double ns = TimeNs(
+          [&] {
+            double total = 0.0;
+            for (size_t i = 0; i + 1 < kRows; i++) {
+              total += kernels->squared_distance_(points.Row(i),
+                                                  points.Row(i + 1), stride);
+            }
+            sink = sink + total;
+          },
+          options.min_seconds_);
+      Report({"kernel",
+              "squared_distance",
+              {{"isa", Quote(kernels->name_)},
+               {"type", Quote(TypeName<T>())},
+               {"d", Number(d)}},
+              ns / (kRows - 1),
+              -1.0,
+              bytes / ns});
+
+      ns = TimeNs(
+          [&] {
+            double total = 0.0;
+            for (size_t i = 0; i + 1 < kRows; i++) {
+              total += kernels->dot_product_(points.Row(i), points.Row(i + 1),
+                                             stride);
+            }
+            sink = sink + total;
+          },
+          options.min_seconds_);
+      Report({"kernel",
+              "dot_product",
+              {{"isa", Quote(kernels->name_)},
+               {"type", Quote(TypeName<T>())},
+               {"d", Number(d)}},
+              ns / (kRows - 1),
+              -1.0,
+              bytes / ns});
+
+      // every point against the first 16 rows as centroids
+      constexpr size_t kCentroids = 16;
+      std::vector<T> norms = SquaredNorms(points);
+      ns = TimeNs(
+          [&] {
+            int total = 0;
+            for (size_t i = 0; i < kRows; i++) {
+              double distance;
+              total += kernels->nearest_centroid_(
+                  points.Row(i), norms[i], points.Data(), norms.data(),
+                  kCentroids, stride, stride, &distance);
+            }
+            sink = sink + total;
+          },
+          options.min_seconds_);
+      Report({"kernel",
+              "nearest_centroid",
+              {{"isa", Quote(kernels->name_)},
+               {"type", Quote(TypeName<T>())},
+               {"d", Number(d)},
+               {"k", Number(kCentroids)}},
+              ns / kRows,
+              ns / (kRows * kCentroids),
+              kRows * stride * sizeof(T) / ns});
+    }
+  }
+}
+
+// one assignment pass over the synthetic points, the way K_Means does it
+// below and above BLOCKED_ASSIGN_MIN_K
+template <typename T>
+void BenchAssignment(const Options& options) {
+  size_t n = options.num_of_points_;
+  size_t d = options.num_of_dimensions_;
+  BasicMatrix<T> points = RandomMatrix<T>(n, d, 2);
+  std::vector<T> point_norms = SquaredNorms(points);
+  size_t stride = points.Stride();
+  const BasicKernels<T>& kernels = GetKernels<T>();
+
+  std::vector<size_t> ks = {8, 64, 256};
+  if (options.quick_) ks = {64};
+
+  for (size_t k : ks) {
+    BasicMatrix<T> centroids = RandomMatrix<T>(k, d, 3);
+    std::vector<T> centroid_norms = SquaredNorms(centroids);
+    std::vector<int> labels(n);
+    std::vector<double> distances(n);
+    double pairs = static_cast<double>(n) * k;
+    double bytes = static_cast<double>(n) * stride * sizeof(T);
+
+    double ns = TimeNs(
+        [&] {
+          for (size_t i = 0; i < n; i++) {
+            labels[i] = kernels.nearest_centroid_(
+                points.Row(i), point_norms[i], centroids.Data(),
+                centroid_norms.data(), k, stride, stride, &distances[i]);
+          }
+        },
+        options.min_seconds_);
+    Report({"assign",
+            "point_at_a_time",
+            {{"isa", Quote(kernels.name_)},
+             {"type", Quote(TypeName<T>())},
+             {"n", Number(n)},
+             {"d", Number(d)},
+             {"k", Number(k)}},
+            ns,
+            ns / pairs,
+            bytes / ns});
+
+    BasicPackedCentroids<T> packed;
+    ns = TimeNs(
+        [&] {
+          PackCentroids(centroids, centroid_norms.data(), packed);
+          for (size_t block = 0; block < n; block += kAssignBlockRows) {
+            size_t rows = std::min(kAssignBlockRows, n - block);
+            AssignBlock(points.Row(block), stride, &point_norms[block], rows,
+                        packed, &labels[block], &distances[block]);
+          }
+        },
+        options.min_seconds_);
+    Report({"assign",
+            "blocked",
+            {{"type", Quote(TypeName<T>())},
+             {"n", Number(n)},
+             {"d", Number(d)},
+             {"k", Number(k)}},
+            ns,
+            ns / pairs,
+            bytes / ns});
+  }
+}
+
+// full recomputation of every cluster sum and mean from a labeling
+void BenchCentroidUpdate(const Options& options) {
+  size_t n = options.num_of_points_;
+  size_t d = options.num_of_dimensions_;
+  Matrix points = RandomMatrix<double>(n, d, 4);
+
+  for (size_t k : {8, 64}) {
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<> distrib(0, static_cast<int>(k) - 1);
+    std::vector<int> labels(n);
+    for (int& label : labels) label = distrib(gen);
+
+    std::vector<Cluster> clusters(k);
+    double ns = TimeNs(
+        [&] {
+          for (Cluster& cluster : clusters) {
+            cluster.sum_.assign(d, 0.0);
+            cluster.num_of_points_ = 0;
+          }
+          for (size_t i = 0; i < n; i++) {
+            AddPointToCluster(clusters[labels[i]], points[i]);
+          }
+          for (Cluster& cluster : clusters) {
+            if (cluster.num_of_points_ > 0) CalculateCentroid(cluster);
+          }
+        },
+        options.min_seconds_);
+    Report({"update",
+            "sums_and_means",
+            {{"n", Number(n)}, {"d", Number(d)}, {"k", Number(k)}},
+            ns,
+            -1.0,
+            n * points.Stride() * sizeof(double) / ns});
+  }
+}
+
+const char* InitializationName(InitializationMethod method) {
+  switch (method) {
+    case InitializationMethod::RANDOM_SELECTION:
+      return "random_selection";
+    case InitializationMethod::RANDOM_PARTITION:
+      return "random_partition";
+    case InitializationMethod::MAX_I_MIN:
+      return "max_i_min";
+    case InitializationMethod::KMEANS_PLUS_PLUS:
+      return "kmeans_plus_plus";
+    case InitializationMethod::KMEANS_PARALLEL:
+      return "kmeans_parallel";
+    default:
+      return "unknown";
+  }
+}
+
+const char* AlgorithmName(Algorithm algorithm) {
+  switch (algorithm) {
+    case Algorithm::LLOYD:
+      return "lloyd";
+    case Algorithm::HAMERLY:
+      return "hamerly";
+    case Algorithm::ELKAN:
+      return "elkan";
+    case Algorithm::YINYANG:
+      return "yinyang";
+    case Algorithm::MINI_BATCH:
+      return "mini_batch";
+    case Algorithm::FILTERING:
+      return "filtering";
+    case Algorithm::BALL_TREE:
+      return "ball_tree";
+    default:
+      return "unknown";
+  }
+}
+
+void BenchDataset(const Options& options, int num_of_threads) {
+  Data data(options.dataset_, 0, 100, 1, 0.001);
+  const Matrix& points = data.GetPoints();
+  size_t n = points.Rows();
+  int k = data.GetNumOfClusters();
+  std::string name = Quote(data.GetFileName());
+  double bytes = static_cast<double>(n) * points.Stride() * sizeof(double);
+
+  Matrix centroids;
+  std::mt19937 gen(6);
+  ThreadPool pool(num_of_threads);
+  for (int m = 0; m < static_cast<int>(InitializationMethod::COUNT); m++) {
+    auto method = static_cast<InitializationMethod>(m);
+    double ns = TimeNs(
+        [&] {
+          if (method == InitializationMethod::RANDOM_SELECTION)
+            data.SelectCentroids(gen, k, centroids);
+          else if (method == InitializationMethod::RANDOM_PARTITION)
+            data.PartitionCentroids(gen, k, centroids);
+          else if (method == InitializationMethod::MAX_I_MIN)
+            data.MaxIMinSelection(gen, k, centroids);
+          else if (method == InitializationMethod::KMEANS_PLUS_PLUS)
+            data.KMeansPlusPlus(gen, k, centroids);
+          else
+            data.KMeansParallel(gen, k, centroids, &pool);
+        },
+        options.min_seconds_);
+    Report({"init",
+            InitializationName(method),
+            {{"dataset", name}, {"n", Number(n)}, {"k", Number(k)}},
+            ns});
+  }
+
+  // two finished runs with different seeds to score
+  K_Means first(&data, InitializationMethod::RANDOM_PARTITION, 1);
+  first.SetSeed(1);
+  first.Run();
+  K_Means second(&data, InitializationMethod::RANDOM_PARTITION, 1);
+  second.SetSeed(2);
+  second.Run();
+
+  Validate validate(&data, num_of_threads);
+  std::vector<ThreadPool*> silhouette_pools = {nullptr};
+  if (pool.GetNumOfThreads() > 1) silhouette_pools.push_back(&pool);
+  for (ThreadPool* silhouette_pool : silhouette_pools) {
+    int threads = silhouette_pool != nullptr ? pool.GetNumOfThreads() : 1;
+    double ns = TimeNs(
+        [&] { validate.SilhouetteWidth(first, silhouette_pool); },
+        options.min_seconds_);
+    Report({"internal",
+            "silhouette_width",
+            {{"dataset", name},
+             {"n", Number(n)},
+             {"k", Number(k)},
+             {"threads", Number(threads)}},
+            ns,
+            ns / (static_cast<double>(n) * n),
+            -1.0});
+  }
+
+  double ns = TimeNs([&] { validate.CalinskiHarabasz(first); },
+                     options.min_seconds_);
+  Report({"internal",
+          "calinski_harabasz",
+          {{"dataset", name}, {"n", Number(n)}, {"k", Number(k)}},
+          ns,
+          -1.0,
+          bytes / ns});
+
+  ExternalValidation external;
+  ns = TimeNs(
+      [&] {
+        external.Evaluate(first.GetBestLabels(), second.GetBestLabels());
+      },
+      options.min_seconds_);
+  Report({"external",
+          "contingency_scores",
+          {{"dataset", name}, {"n", Number(n)}, {"k", Number(k)}},
+          ns});
+}
+
+// whole runs of every dataset in the directory, timed once each since a run
+// already repeats num_of_runs_ restarts
+void BenchRuns(const Options& options, int max_threads) {
+  std::vector<std::filesystem::path> paths;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(options.datasets_)) {
+    if (entry.path().extension() == ".txt" &&
+        entry.path().stem() != "attributes") {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+
+  std::vector<int> ks = {8, 32, 128};
+  std::vector<int> thread_counts = {1};
+  if (max_threads > 1) thread_counts.push_back(max_threads);
+  if (options.quick_) ks = {8, 32};
+
+  for (const std::filesystem::path& path : paths) {
+    Data data(path.string(), 0, 100, options.num_of_runs_, 0.001);
+    const Matrix& points = data.GetPoints();
+    size_t n = points.Rows();
+
+    // the KD-tree only pays off in few dimensions
+    std::vector<Algorithm> algorithms = {Algorithm::LLOYD, Algorithm::HAMERLY,
+                                         Algorithm::ELKAN, Algorithm::YINYANG,
+                                         Algorithm::MINI_BATCH};
+    if (points.Cols() <= FILTERING_MAX_DIMENSIONS) {
+      algorithms.push_back(Algorithm::FILTERING);
+    }
+    algorithms.push_back(Algorithm::BALL_TREE);
+
+    for (int k : ks) {
+      if (static_cast<size_t>(k) * 2 > n) continue;
+
+      for (Algorithm algorithm : algorithms) {
+        // below BALL_TREE_MIN_K the ball tree engine is the Lloyd loop
+        if (algorithm == Algorithm::BALL_TREE && k < BALL_TREE_MIN_K) continue;
+
+        // the Lloyd loop is the one that reads single precision, its SSE is
+        // reported next to the double run's
+        std::vector<Precision> precisions = {Precision::FLOAT64};
+        if (algorithm == Algorithm::LLOYD) {
+          precisions.push_back(Precision::FLOAT32);
+        }
+
+        for (Precision precision : precisions) {
+          for (int threads : thread_counts) {
+            K_Means k_means(&data, InitializationMethod::RANDOM_PARTITION,
+                            threads);
+            k_means.SetNumOfClusters(k);
+            k_means.SetSeed(1);
+            k_means.SetAlgorithm(algorithm);
+            k_means.SetBatchSize(options.batch_size_);
+            k_means.SetPrecision(precision);
+
+            auto start = std::chrono::steady_clock::now();
+            k_means.Run();
+            double ns = std::chrono::duration<double, std::nano>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+
+            // as if every pass read each point once for k distances
+            bool single = precision == Precision::FLOAT32;
+            size_t row_bytes =
+                single ? FloatMatrix::PaddedStride(points.Cols()) *
+                             sizeof(float)
+                       : points.Stride() * sizeof(double);
+            double distances =
+                static_cast<double>(k_means.GetNumOfDistanceEvaluations());
+            double bytes = distances / k * row_bytes;
+            Result result{
+                "run",
+                AlgorithmName(algorithm),
+                {{"dataset", Quote(data.GetFileName())},
+                 {"type", Quote(single ? "float32" : "float64")},
+                 {"n", Number(n)},
+                 {"d", Number(points.Cols())},
+                 {"k", Number(k)},
+                 {"threads", Number(threads)},
+                 {"restarts", Number(options.num_of_runs_)},
+                 {"sse", Number(k_means.GetLowestFinalSSE())},
+                 {"steady_state_allocations",
+                  Number(k_means.GetNumOfSteadyStateAllocations())}},
+                ns,
+                ns / distances,
+                bytes / ns};
+            if (algorithm == Algorithm::MINI_BATCH) {
+              result.params_.push_back(
+                  {"batch_size", Number(options.batch_size_)});
+            }
+            Report(std::move(result));
+          }
+        }
+      }
+    }
+  }
+}
+
+void WriteJson(const std::string& path, int max_threads) {
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) std::filesystem::create_directories(parent);
+
+  std::ofstream out(path);
+  if (!out.is_open()) {
+    std::cout << "Error opening output file: " << path << std::endl;
+    std::exit(1);
+  }
+
+  out << "{\n  \"kernels\": " << Quote(GetKernels().name_)
+      << ",\n  \"hardware_threads\": " << max_threads
+      << ",\n  \"results\": [\n";
+  for (size_t r = 0; r < results.size(); r++) {
+    const Result& result = results[r];
+    out << "    {\"group\": " << Quote(result.group_)
+        << ", \"name\": " << Quote(result.name_) << ", \"params\": {";
+    for (size_t p = 0; p < result.params_.size(); p++) {
+      out << (p > 0 ? ", " : "") << Quote(result.params_[p].first) << ": "
+          << result.params_[p].second;
+    }
+    out << "}, \"ns_per_op\": " << Number(result.ns_per_op_);
+    if (result.ns_per_point_centroid_ >= 0.0) {
+      out << ", \"ns_per_point_centroid\": "
+          << Number(result.ns_per_point_centroid_);
+    }
+    if (result.gb_per_s_ >= 0.0) {
+      out << ", \"gb_per_s\": " << Number(result.gb_per_s_);
+    }
+    out << "}" << (r + 1 < results.size() ? "," : "") << "\n";
+  }
+  out << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--datasets" && i + 1 < argc) {
+      options.datasets_ = argv[++i];
+    } else if (arg == "--dataset" && i + 1 < argc) {
+      options.dataset_ = argv[++i];
+    } else if (arg == "--json" && i + 1 < argc) {
+      options.json_ = argv[++i];
+    } else if (arg == "--runs" && i + 1 < argc) {
+      options.num_of_runs_ = std::stoi(argv[++i]);
+    } else if (arg == "--batch-size" && i + 1 < argc) {
+      options.batch_size_ = std::stoi(argv[++i]);
+    } else if (arg == "--quick") {
+      options.quick_ = true;
+      options.min_seconds_ = 0.05;
+      options.num_of_points_ = 4096;
+    } else {
+      std::cout << "Usage: " << argv[0]
+                << " [--datasets <dir>] [--dataset <file>] [--json <file>] "
+                   "[--runs <restarts>] [--batch-size <points>] "
+                   "[--quick]\n"
+                << "Runs from the repository root by default, reading "
+                   "datasets/ and writing outputs/bench.json.\n";
+      return 1;
+    }
+  }
+  if (options.dataset_.empty()) {
+    options.dataset_ = options.datasets_ + "/landsat.txt";
+  }
+
+  int max_threads =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  BenchKernels<double>(options);
+  BenchKernels<float>(options);
+  BenchAssignment<double>(options);
+  BenchAssignment<float>(options);
+  BenchCentroidUpdate(options);
+  BenchDataset(options, max_threads);
+  BenchRuns(options, max_threads);
+
+  WriteJson(options.json_, max_threads);
+  std::cout << "Wrote " << results.size() << " results to " << options.json_
+            << std::endl;
+  return 0;
+}
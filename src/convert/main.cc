@@ -0,0 +1,73 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+// Converts text datasets into the binary format Data memory maps. Each
+// input is written next to itself with a .bin extension, after which every
+// executable reading the .txt path picks up the binary copy instead. A
+// --float32 copy is only picked up when CLUSTERING_PRECISION is FLOAT32.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../data/dataset_io.h"
+#include "../util/config.h"
+
+int main(int argc, char* argv[]) {
+  NormalizationMethod normalization = NormalizationMethod::COUNT;
+  DataType dtype = DataType::FLOAT64;
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--normalize" && i + 1 < argc) {
+      std::string method = argv[++i];
+      if (method == "min_max") {
+        normalization = NormalizationMethod::MIN_MAX;
+      } else if (method == "z_score") {
+        normalization = NormalizationMethod::Z_SCORE;
+      } else {
+        std::cout << "Unknown normalization: " << method << std::endl;
+        return 1;
+      }
+    } else if (arg == "--float32") {
+      dtype = DataType::FLOAT32;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+
+  if (inputs.empty()) {
+    std::cout << "Usage: " << argv[0]
+              << " [--normalize min_max|z_score] [--float32] "
+                 "<dataset.txt>...\n"
+              << "Writes <dataset>.bin next to each input. Normalized files "
+                 "are only used when the same normalization is requested, "
+                 "--float32 files only when CLUSTERING_PRECISION is "
+                 "FLOAT32.\n";
+    return 1;
+  }
+
+  for (const std::string& input : inputs) {
+    DatasetContents contents;
+    ReadTextDataset(input, contents);
+
+    if (normalization == NormalizationMethod::MIN_MAX) {
+      MinMaxNormalize(contents.points_);
+    } else if (normalization == NormalizationMethod::Z_SCORE) {
+      ZScoreNormalize(contents.points_);
+    }
+
+    std::string output = BinaryDatasetPath(input);
+    WriteBinaryDataset(output, contents, normalization, dtype);
+
+    std::cout << input << " -> " << output << " ("
+              << contents.points_.Rows() << " x " << contents.points_.Cols()
+              << (contents.labels_.empty() ? "" : ", labeled") << ")"
+              << std::endl;
+  }
+
+  return 0;
+}
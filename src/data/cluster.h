@@ -8,11 +8,15 @@
 
 #include <vector>
 
+// Membership is kept outside the cluster as a label per point, a cluster only
+// stores its centroid and the running sum of the points assigned to it
 struct Cluster {
-  std::vector<std::vector<double>> points_;
   std::vector<double> centroid_;
+  double squared_norm_ = 0.0;  // of centroid_, updated alongside it
+  std::vector<double> sum_;
+  int num_of_points_ = 0;
   double worst_distance_;
-  int pos_of_worst_point_;
+  int pos_of_worst_point_;  // index into the point matrix
 };
 
 #endif  // CLUSTER_H_
@@ -6,13 +6,40 @@
 #include "./data.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <numeric>
 #include <string>
 #include <vector>
 
 #include "../util/math.h"
+#include "../util/thread_pool.h"
 #include "./cluster.h"
+#include "./dataset_io.h"
+
+// index drawn with probability weights[i] / total, uniform when every weight
+// is zero (all remaining points coincide with a chosen centroid)
+static int SampleByWeight(std::mt19937& gen,
+                          const std::vector<double>& weights, double total) {
+  if (total <= 0.0) {
+    std::uniform_int_distribution<> distrib(0, weights.size() - 1);
+    return distrib(gen);
+  }
+
+  std::uniform_real_distribution<> distrib(0.0, total);
+  double target = distrib(gen);
+  int last_positive = 0;
+  for (size_t i = 0; i < weights.size(); i++) {
+    if (weights[i] <= 0.0) continue;
+    last_positive = i;
+    target -= weights[i];
+    if (target < 0.0) return i;
+  }
+
+  // rounding left a sliver of the total unclaimed
+  return last_positive;
+}
 
 // Define class variables and conduct main class code
 Data::Data(std::string file_path, int num_of_clusters, int max_iterations,
@@ -25,21 +52,21 @@ Data::Data(std::string file_path, int num_of_clusters, int max_iterations,
       convergence_threshold_(convergence_threshold),
       knormalization_method_(normalization_method) {
   ReadPoints();
-  if (knormalization_method_ == NormalizationMethod::MIN_MAX)
+  if (stored_normalization_ == knormalization_method_)
+    CalculateSquaredNormsPoints();
+  else if (knormalization_method_ == NormalizationMethod::MIN_MAX)
     MinMaxNormalization();
   else if (knormalization_method_ == NormalizationMethod::Z_SCORE)
     ZScoreNormalization();
 }
 
-void Data::CheckClusters() {
+void Data::CheckClusters(int num_of_clusters, Matrix& centroids) const {
   if (!num_of_points_ || !num_of_dimensions_) {
     std::cout << "readPoints() must be ran before selectCentroids() is called.";
     std::exit(1);
   }
 
-  if (!centroids_.empty()) {
-    centroids_.clear();
-  }
+  centroids.Resize(num_of_clusters, num_of_dimensions_);
 }
 
 int Data::GetNumOfPoints() { return num_of_points_; }
@@ -64,14 +91,11 @@ std::string Data::GetFileName() {
 
 double Data::GetConvergenceThreshold() { return convergence_threshold_; }
 
-std::vector<std::vector<double>> Data::GetPoints() { return points_; }
-
-std::vector<std::vector<double>> Data::GetCentroids() { return centroids_; }
-
-void Data::SetCentroids(std::vector<std::vector<double>> new_centroids) {
-  centroids_.clear();
+void Data::SetCentroids(const Matrix& new_centroids) {
+  centroids_.Resize(num_of_clusters_, num_of_dimensions_);
   for (int i = 0; i < num_of_clusters_; i++) {
-    centroids_.push_back(new_centroids[i]);
+    std::copy(new_centroids[i].begin(), new_centroids[i].end(),
+              centroids_.Row(i));
   }
 }
 
@@ -86,57 +110,69 @@ void Data::PrintPoints() {
 
 // select random centroids based on how many clusters there are
 // read points must be ran before this is called
-void Data::SelectCentroids() {
-  CheckClusters();
+void Data::SelectCentroids(std::mt19937& gen, int num_of_clusters,
+                           Matrix& centroids) const {
+  CheckClusters(num_of_clusters, centroids);
 
   std::uniform_int_distribution<> distrib(0, num_of_points_ - 1);
 
   std::vector<int> used_indices;
 
-  for (int i = 0; i < num_of_clusters_; i++) {
-    int random_index = distrib(gen_);
+  for (int i = 0; i < num_of_clusters; i++) {
+    int random_index = distrib(gen);
 
     for (int j = 0; j < used_indices.size(); j++) {
       if (used_indices[j] == random_index) {
-        random_index = distrib(gen_);
+        random_index = distrib(gen);
         j--;
       }
     }
 
     used_indices.push_back(random_index);
-    centroids_.push_back(points_[random_index]);
+    std::copy(points_[random_index].begin(), points_[random_index].end(),
+              centroids.Row(i));
   }
 }
 
-void Data::PartitionCentroids() {
-  CheckClusters();
+void Data::PartitionCentroids(std::mt19937& gen, int num_of_clusters,
+                              Matrix& centroids) const {
+  CheckClusters(num_of_clusters, centroids);
 
-  std::uniform_int_distribution<> distrib(0, num_of_clusters_ - 1);
-
-  std::vector<Cluster> temp_clusters(num_of_clusters_);
+  std::uniform_int_distribution<> distrib(0, num_of_clusters - 1);
 
+  // the rows of centroids hold the sums until the division, nothing is
+  // copied per cluster
+  std::vector<int> counts(num_of_clusters, 0);
   for (int i = 0; i < num_of_points_; i++) {
-    int cluster_index = distrib(gen_);
-    temp_clusters[cluster_index].points_.push_back(points_[i]);
+    int cluster_index = distrib(gen);
+    double* sum = centroids.Row(cluster_index);
+    const double* point = points_.Row(i);
+    for (int j = 0; j < num_of_dimensions_; j++) sum[j] += point[j];
+    counts[cluster_index]++;
   }
 
-  for (int i = 0; i < num_of_clusters_; i++) {
-    CalculateCentroid(temp_clusters[i]);
-    centroids_.push_back(temp_clusters[i].centroid_);
+  // an empty cluster keeps the zero row
+  for (int i = 0; i < num_of_clusters; i++) {
+    if (counts[i] == 0) continue;
+    double* centroid = centroids.Row(i);
+    for (int j = 0; j < num_of_dimensions_; j++) centroid[j] /= counts[i];
   }
 }
 
-void Data::MaxIMinSelection() {
-  CheckClusters();
+void Data::MaxIMinSelection(std::mt19937& gen, int num_of_clusters,
+                            Matrix& centroids) const {
+  CheckClusters(num_of_clusters, centroids);
 
   std::uniform_int_distribution<> distrib(0, num_of_points_ - 1);
 
-  centroids_.push_back(points_[distrib(gen_)]);
+  int first_index = distrib(gen);
+  std::copy(points_[first_index].begin(), points_[first_index].end(),
+            centroids.Row(0));
 
   // Note: should come out to be O(NDK), points, attributes, clusters
   // In reality, I think it is closer to O(ND K^2) atm
   /*
-  while (centroids_.size() < num_of_clusters_) {
+  while (centroids_.size() < num_of_clusters) {
     int max_distance_index = 0;
     double max_distance = 0.0;
 
@@ -157,12 +193,10 @@ void Data::MaxIMinSelection() {
   // keep tally of minimum distances so we can always find the best point
   std::vector<double> min_distances(num_of_points_,
                                     std::numeric_limits<double>::max());
+  UpdateMinDistances(centroids[0], 0, min_distances, nullptr, 0,
+                     num_of_points_);
 
-  for (int i = 0; i < num_of_points_; i++) {
-    min_distances[i] = GetDistance(points_[i], centroids_[0]);
-  }
-
-  while (centroids_.size() < num_of_clusters_) {
+  for (int c = 1; c < num_of_clusters; c++) {
     int index = 0;
     double max_min_distance = std::numeric_limits<double>::min();
 
@@ -173,99 +207,350 @@ void Data::MaxIMinSelection() {
       }
     }
 
-    centroids_.push_back(points_[index]);
+    std::copy(points_[index].begin(), points_[index].end(),
+              centroids.Row(c));
+    UpdateMinDistances(centroids[c], c, min_distances, nullptr, 0,
+                       num_of_points_);
+  }
+}
 
-    for (int i = 0; i < num_of_points_; i++) {
-      double dist = GetDistance(points_[i], centroids_.back());
-      if (dist < min_distances[i]) {
-        min_distances[i] = dist;
-      }
+void Data::UpdateMinDistances(std::span<const double> centroid, int index,
+                              std::vector<double>& min_distances,
+                              std::vector<int>* nearest, size_t begin,
+                              size_t end) const {
+  for (size_t i = begin; i < end; i++) {
+    double dist = GetDistance(points_[i], centroid);
+    if (dist < min_distances[i]) {
+      min_distances[i] = dist;
+      if (nearest != nullptr) (*nearest)[i] = index;
     }
   }
 }
 
-void Data::ReadPoints() {
-  std::ifstream file(kfile_path_);
+// k-means++ (Arthur and Vassilvitskii 2007), same min distance tally as
+// Max-I-Min but the next centroid is drawn with probability proportional to
+// the squared distance instead of taking the farthest point, so outliers are
+// favoured without being guaranteed a centroid
+void Data::KMeansPlusPlus(std::mt19937& gen, int num_of_clusters,
+                          Matrix& centroids) const {
+  CheckClusters(num_of_clusters, centroids);
+
+  std::uniform_int_distribution<> distrib(0, num_of_points_ - 1);
 
-  if (!file.is_open()) {
-    std::cout << "File failed to open. PATH :: " << kfile_path_ << std::endl;
+  int first_index = distrib(gen);
+  std::copy(points_[first_index].begin(), points_[first_index].end(),
+            centroids.Row(0));
+
+  std::vector<double> min_distances(num_of_points_,
+                                    std::numeric_limits<double>::max());
+  UpdateMinDistances(centroids[0], 0, min_distances, nullptr, 0,
+                     num_of_points_);
+
+  for (int c = 1; c < num_of_clusters; c++) {
+    double total =
+        std::accumulate(min_distances.begin(), min_distances.end(), 0.0);
+    int index = SampleByWeight(gen, min_distances, total);
+
+    std::copy(points_[index].begin(), points_[index].end(),
+              centroids.Row(c));
+    UpdateMinDistances(centroids[c], c, min_distances, nullptr, 0,
+                       num_of_points_);
   }
+}
+
+// k-means|| (Bahmani et al. 2012). k-means++ needs k passes over the data,
+// one per centroid, k-means|| instead takes a few rounds that each keep every
+// point independently with probability l * d^2 / cost, with l = oversampling
+// factor times k. The passes that update the min distances against the new
+// candidates split the points across the pool. The candidates, weighted by
+// how many points are closest to them, are then reduced to k centroids with
+// a weighted k-means++ and a few weighted Lloyd iterations.
+void Data::KMeansParallel(std::mt19937& gen, int num_of_clusters,
+                          Matrix& centroids, ThreadPool* pool) const {
+  CheckClusters(num_of_clusters, centroids);
+
+  std::uniform_int_distribution<> distrib(0, num_of_points_ - 1);
+
+  std::vector<int> candidates;  // indices into points_
+  candidates.push_back(distrib(gen));
+
+  std::vector<double> min_distances(num_of_points_,
+                                    std::numeric_limits<double>::max());
+  std::vector<int> nearest(num_of_points_, 0);
+
+  // score every point against the candidates added from first_new onwards
+  auto update_candidates = [&](size_t first_new) {
+    auto update_range = [&](size_t begin, size_t end, int) {
+      for (size_t c = first_new; c < candidates.size(); c++) {
+        UpdateMinDistances(points_[candidates[c]], c, min_distances,
+                           &nearest, begin, end);
+      }
+    };
+    if (pool != nullptr) {
+      pool->ParallelFor(num_of_points_, update_range);
+    } else {
+      update_range(0, num_of_points_, 0);
+    }
+  };
+  update_candidates(0);
+
+  double oversampling = KMEANS_PARALLEL_OVERSAMPLING * num_of_clusters;
+  std::uniform_real_distribution<> unit(0.0, 1.0);
+
+  for (int round = 0; round < KMEANS_PARALLEL_ROUNDS; round++) {
+    double cost =
+        std::accumulate(min_distances.begin(), min_distances.end(), 0.0);
+    if (cost <= 0.0) break;
 
-  // first two entries in file are points and dimensions
-  file >> num_of_points_;
-  file >> num_of_dimensions_;
-  num_of_dimensions_ -= 1;
-  if (num_of_clusters_ == 0) file >> num_of_clusters_;
+    size_t first_new = candidates.size();
+    for (int i = 0; i < num_of_points_; i++) {
+      if (unit(gen) * cost < oversampling * min_distances[i]) {
+        candidates.push_back(i);
+      }
+    }
+    update_candidates(first_new);
+  }
 
-  points_.resize(num_of_points_, std::vector<double>(num_of_dimensions_));
+  // small datasets can come up short, fill in with D^2 sampling
+  while (candidates.size() < static_cast<size_t>(num_of_clusters)) {
+    double cost =
+        std::accumulate(min_distances.begin(), min_distances.end(), 0.0);
+    size_t first_new = candidates.size();
+    candidates.push_back(SampleByWeight(gen, min_distances, cost));
+    update_candidates(first_new);
+  }
 
+  int num_of_candidates = candidates.size();
+  std::vector<double> weights(num_of_candidates, 0.0);
   for (int i = 0; i < num_of_points_; i++) {
-    for (int j = 0; j < num_of_dimensions_; j++) {
-      file >> points_[i][j];
+    weights[nearest[i]] += 1.0;
+  }
+
+  // weighted k-means++ over the candidates
+  std::vector<double> candidate_distances(num_of_candidates,
+                                          std::numeric_limits<double>::max());
+  std::vector<double> scores(num_of_candidates);
+  for (int c = 0; c < num_of_clusters; c++) {
+    double total = 0.0;
+    for (int j = 0; j < num_of_candidates; j++) {
+      scores[j] = c == 0 ? weights[j] : weights[j] * candidate_distances[j];
+      total += scores[j];
+    }
+    int chosen = candidates[SampleByWeight(gen, scores, total)];
+    std::copy(points_[chosen].begin(), points_[chosen].end(),
+              centroids.Row(c));
+
+    for (int j = 0; j < num_of_candidates; j++) {
+      double dist = GetDistance(points_[candidates[j]], centroids[c]);
+      candidate_distances[j] = std::min(candidate_distances[j], dist);
     }
-    int label;
-    file >> label;
-    true_labels_.push_back(label);
   }
 
-  file.close();
+  // weighted Lloyd iterations over the candidates
+  std::vector<int> assignment(num_of_candidates, -1);
+  std::vector<Cluster> temp_clusters(num_of_clusters);
+  std::vector<double> cluster_weights(num_of_clusters);
+
+  for (int iter = 0; iter < KMEANS_PARALLEL_RECLUSTER_ITERATIONS; iter++) {
+    bool changed = false;
+    for (int j = 0; j < num_of_candidates; j++) {
+      int best = 0;
+      double best_distance = std::numeric_limits<double>::max();
+      for (int c = 0; c < num_of_clusters; c++) {
+        double dist = GetDistance(points_[candidates[j]], centroids[c]);
+        if (dist < best_distance) {
+          best_distance = dist;
+          best = c;
+        }
+      }
+      if (assignment[j] != best) {
+        assignment[j] = best;
+        changed = true;
+      }
+    }
+    if (!changed) break;
+
+    for (int c = 0; c < num_of_clusters; c++) {
+      temp_clusters[c].sum_.assign(num_of_dimensions_, 0.0);
+      cluster_weights[c] = 0.0;
+    }
+    for (int j = 0; j < num_of_candidates; j++) {
+      std::span<const double> point = points_[candidates[j]];
+      Cluster& cluster = temp_clusters[assignment[j]];
+      for (int d = 0; d < num_of_dimensions_; d++) {
+        cluster.sum_[d] += weights[j] * point[d];
+      }
+      cluster_weights[assignment[j]] += weights[j];
+    }
+
+    // a centroid that lost all its weight stays where it was
+    for (int c = 0; c < num_of_clusters; c++) {
+      if (cluster_weights[c] <= 0.0) continue;
+      for (int d = 0; d < num_of_dimensions_; d++) {
+        centroids.Row(c)[d] = temp_clusters[c].sum_[d] / cluster_weights[c];
+      }
+    }
+  }
+}
+
+void Data::ReadPoints() {
+  // an up to date convert_dataset copy of the precision runs cluster with
+  // skips parsing entirely
+  std::string path = ResolveDatasetPath(
+      kfile_path_, CLUSTERING_PRECISION == Precision::FLOAT32
+                       ? DataType::FLOAT32
+                       : DataType::FLOAT64);
+  int file_num_of_clusters = 0;
+
+  if (!IsBinaryDataset(path) || !MapPoints(path, file_num_of_clusters)) {
+    // nothing to fall back to when the binary file was given directly
+    if (IsBinaryDataset(kfile_path_)) {
+      std::cout << kfile_path_ << ": binary dataset is normalized differently "
+                << "than requested" << std::endl;
+      std::exit(1);
+    }
+
+    DatasetContents contents;
+    ReadTextDataset(kfile_path_, contents);
+    points_ = std::move(contents.points_);
+    true_labels_ = std::move(contents.labels_);
+    file_num_of_clusters = contents.num_of_clusters_;
+  }
+
+  num_of_points_ = points_.Rows();
+  num_of_dimensions_ = points_.Cols();
+  if (num_of_clusters_ == 0) num_of_clusters_ = file_num_of_clusters;
 
   if (num_of_clusters_ <= 0) {
     num_of_clusters_ = sqrt(num_of_points_ / 2);
   }
 }
 
-void Data::MinMaxNormalization() {
-  std::vector<double> min_vals(num_of_dimensions_,
-                               std::numeric_limits<double>::max());
-  std::vector<double> max_vals(num_of_dimensions_,
-                               std::numeric_limits<double>::lowest());
-
-  for (int j = 0; j < num_of_dimensions_; j++) {
-    min_vals[j] = points_[0][j];
-    max_vals[j] = points_[0][j];
-    for (int i = 1; i < num_of_points_; i++) {
-      if (points_[i][j] < min_vals[j]) {
-        min_vals[j] = points_[i][j];
-      }
-      if (points_[i][j] > max_vals[j]) {
-        max_vals[j] = points_[i][j];
+bool Data::MapPoints(const std::string& path, int& file_num_of_clusters) {
+  const BinaryDatasetHeader& header = MapBinaryDataset(path, mapping_);
+
+  if (header.normalization_ !=
+          static_cast<uint32_t>(NormalizationMethod::COUNT) &&
+      header.normalization_ !=
+          static_cast<uint32_t>(knormalization_method_)) {
+    mapping_.Close();
+    return false;
+  }
+
+  size_t rows = header.num_of_points_;
+  size_t cols = header.num_of_dimensions_;
+  char* base = mapping_.MutableData();
+
+  if (header.dtype_ == static_cast<uint32_t>(DataType::FLOAT32)) {
+    float* features = reinterpret_cast<float*>(base + header.features_offset_);
+    points_.Resize(rows, cols);
+    for (size_t i = 0; i < rows; i++) {
+      std::copy(features + i * header.stride_,
+                features + i * header.stride_ + cols, points_.Row(i));
+    }
+
+    // the file can stand in for the float copy when no normalization is
+    // left to apply to it
+    if (header.normalization_ ==
+            static_cast<uint32_t>(knormalization_method_) &&
+        header.stride_ == FloatMatrix::PaddedStride(cols) &&
+        reinterpret_cast<uintptr_t>(features) % ROW_ALIGNMENT_BYTES == 0) {
+      float_points_ = FloatMatrix(features, rows, cols, header.stride_);
+    }
+  } else {
+    double* features =
+        reinterpret_cast<double*>(base + header.features_offset_);
+
+    // files written with another ROW_ALIGNMENT_BYTES need their rows
+    // repacked
+    if (header.stride_ == Matrix::PaddedStride(cols) &&
+        reinterpret_cast<uintptr_t>(features) % ROW_ALIGNMENT_BYTES == 0) {
+      points_ = Matrix(features, rows, cols, header.stride_);
+    } else {
+      points_.Resize(rows, cols);
+      for (size_t i = 0; i < rows; i++) {
+        std::copy(features + i * header.stride_,
+                  features + i * header.stride_ + cols, points_.Row(i));
       }
     }
+  }
 
-    double range = max_vals[j] - min_vals[j];
+  true_labels_.clear();
+  if (header.has_labels_) {
+    const int32_t* labels =
+        reinterpret_cast<const int32_t*>(base + header.labels_offset_);
+    true_labels_.assign(labels, labels + rows);
+  }
+
+  file_num_of_clusters = header.num_of_clusters_;
+  if (header.normalization_ !=
+      static_cast<uint32_t>(NormalizationMethod::COUNT)) {
+    stored_normalization_ = knormalization_method_;
+  }
+  return true;
+}
 
-    range = std::max(range, 1e-9);  // prevent division by zero
+void Data::CalculateSquaredNormsPoints() {
+  squared_norms_.resize(num_of_points_);
+  for (int i = 0; i < num_of_points_; i++) {
+    squared_norms_[i] = CalculateSquaredNorm(points_[i]);
+  }
+}
 
+void Data::BuildFloatPoints() {
+  if (float_points_.Rows() != points_.Rows()) {
+    float_points_.Resize(num_of_points_, num_of_dimensions_);
     for (int i = 0; i < num_of_points_; i++) {
-      points_[i][j] = (points_[i][j] - min_vals[j]) / range;
+      std::copy(points_[i].begin(), points_[i].end(), float_points_.Row(i));
     }
   }
 }
 
-void Data::ZScoreNormalization() {
-  std::vector<double> stdev(num_of_dimensions_, 0.0);
-  std::vector<double> mean(num_of_dimensions_, 0.0);
+const FloatMatrix& Data::GetFloatPoints() {
+  std::lock_guard<std::mutex> lock(float_points_mutex_);
+  BuildFloatPoints();
+  return float_points_;
+}
 
-  for (int i = 0; i < num_of_dimensions_; i++) {
-    for (int j = 0; j < num_of_points_; j++) {
-      mean[i] += points_[j][i];
+const std::vector<float>& Data::GetFloatSquaredNorms() {
+  std::lock_guard<std::mutex> lock(float_points_mutex_);
+  if (float_squared_norms_.size() != static_cast<size_t>(num_of_points_)) {
+    BuildFloatPoints();
+    const FloatMatrix& points = float_points_;
+    const FloatKernels& kernels = GetKernels<float>();
+    float_squared_norms_.resize(num_of_points_);
+    for (int i = 0; i < num_of_points_; i++) {
+      float_squared_norms_[i] =
+          kernels.dot_product_(points.Row(i), points.Row(i), points.Stride());
     }
-    mean[i] /= num_of_points_;
+  }
+  return float_squared_norms_;
+}
 
-    double sum = 0.0;
-    for (int j = 0; j < num_of_points_; j++) {
-      double diff = points_[j][i] - mean[i];
-      sum += diff * diff;
-    }
+const KdTree& Data::GetKdTree() {
+  std::lock_guard<std::mutex> lock(kd_tree_mutex_);
+  if (kd_tree_.Empty() && num_of_points_ > 0) {
+    kd_tree_ = KdTree(points_, squared_norms_);
+  }
+  return kd_tree_;
+}
 
-    stdev[i] = sqrt(sum);
-    stdev[i] = std::max(stdev[i], 1e-9);
+void Data::MinMaxNormalization() {
+  MinMaxNormalize(points_);
+  CalculateSquaredNormsPoints();
+  // the float copy and the KD-tree are rebuilt when next requested
+  float_points_ = FloatMatrix();
+  float_squared_norms_.clear();
+  kd_tree_ = KdTree();
+}
 
-    for (int j = 0; j < num_of_points_; j++) {
-      points_[j][i] = (points_[j][i] - mean[i]) / stdev[i];
-    }
-  }
+void Data::ZScoreNormalization() {
+  ZScoreNormalize(points_);
+  CalculateSquaredNormsPoints();
+  // the float copy and the KD-tree are rebuilt when next requested
+  float_points_ = FloatMatrix();
+  float_squared_norms_.clear();
+  kd_tree_ = KdTree();
 }
 
 void Data::PrintData() {
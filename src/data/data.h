@@ -10,11 +10,18 @@
 #include <ctime>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <random>
+#include <span>
 #include <string>
 #include <vector>
 
 #include "../util/config.h"
+#include "../util/mapped_file.h"
+#include "./kd_tree.h"
+#include "./matrix.h"
+
+class ThreadPool;
 
 class Data {
  private:
@@ -26,17 +33,42 @@ class Data {
   int num_of_runs_;
   double convergence_threshold_;
   const NormalizationMethod knormalization_method_;
-  std::vector<std::vector<double>> points_;
-  std::vector<std::vector<double>> centroids_;
+  // backs points_ when the dataset was loaded from a binary file
+  MappedFile mapping_;
+  Matrix points_;
+  // ||x||^2 of every point, fixed once the points are normalized
+  std::vector<double> squared_norms_;
+  // single precision copy for FLOAT32 runs, built on first request by
+  // whichever K_Means asks first
+  FloatMatrix float_points_;
+  std::vector<float> float_squared_norms_;
+  std::mutex float_points_mutex_;
+  // filtering k-means tree over the normalized points, built on first request
+  // and shared by every K_Means on this Data
+  KdTree kd_tree_;
+  std::mutex kd_tree_mutex_;
+  Matrix centroids_;
+  // normalization the loaded points already carry, COUNT for raw data
+  NormalizationMethod stored_normalization_ = NormalizationMethod::COUNT;
   std::random_device rd_;
   std::mt19937 gen_{rd_()};
   std::vector<int> true_labels_;
 
   void ReadPoints();
-  void CheckClusters();
+  // maps a convert_dataset file, returns false when its points were
+  // normalized differently than requested and must be read from text
+  bool MapPoints(const std::string& path, int& file_num_of_clusters);
+  void CheckClusters(int num_of_clusters, Matrix& centroids) const;
+  // lowers min_distances[i] to the distance from point i to centroid
+  // wherever that is closer, nearest[i] records which candidate did it
+  void UpdateMinDistances(std::span<const double> centroid, int index,
+                          std::vector<double>& min_distances,
+                          std::vector<int>* nearest, size_t begin,
+                          size_t end) const;
   void PrintPoints();
   void CalculateSquaredNormsPoints();
-  void CalculateSquaredNormsCentroids();
+  // fills float_points_ if it is stale, float_points_mutex_ must be held
+  void BuildFloatPoints();
 
  public:
   Data(std::string file_path, int num_of_clusters = 0, int max_iterations = 100,
@@ -51,20 +83,50 @@ class Data {
   NormalizationMethod GetNormalizationMethod();
   std::string GetFileName();
   double GetConvergenceThreshold();
-  std::vector<std::vector<double>> GetPoints();
-  std::vector<std::vector<double>> GetCentroids();
-  void SetCentroids(std::vector<std::vector<double>> new_centroids);
+  const Matrix& GetPoints() const { return points_; }
+  const std::vector<double>& GetSquaredNorms() const { return squared_norms_; }
+  // safe to call from several threads, the first call builds the copy
+  const FloatMatrix& GetFloatPoints();
+  const std::vector<float>& GetFloatSquaredNorms();
+  // safe to call from several threads, the first call builds the tree
+  const KdTree& GetKdTree();
+  const Matrix& GetCentroids() const { return centroids_; }
+  std::span<const double> GetPoint(int i) const { return points_[i]; }
+  std::span<const double> GetCentroid(int i) const { return centroids_[i]; }
+  void SetCentroids(const Matrix& new_centroids);
   void SetNumOfClusters(int k) { num_of_clusters_ = k; }
   void PrintData();
   void PrintCentroids();
-  void SelectCentroids();     // random selection
-  void PartitionCentroids();  // random partition
-  void MaxIMinSelection();
+  void SelectCentroids() {
+    SelectCentroids(gen_, num_of_clusters_, centroids_);
+  }
+  void PartitionCentroids() {
+    PartitionCentroids(gen_, num_of_clusters_, centroids_);
+  }
+  void MaxIMinSelection() {
+    MaxIMinSelection(gen_, num_of_clusters_, centroids_);
+  }
+
+  // Variants that leave Data untouched so independent runs can initialize
+  // concurrently, each with its own generator, centroid matrix and number of
+  // clusters
+  void SelectCentroids(std::mt19937& gen, int num_of_clusters,
+                       Matrix& centroids) const;  // random selection
+  void PartitionCentroids(std::mt19937& gen, int num_of_clusters,
+                          Matrix& centroids) const;  // random partition
+  void MaxIMinSelection(std::mt19937& gen, int num_of_clusters,
+                        Matrix& centroids) const;
+  void KMeansPlusPlus(std::mt19937& gen, int num_of_clusters,
+                      Matrix& centroids) const;
+  // pool may be nullptr, the distance updates then run on the caller
+  void KMeansParallel(std::mt19937& gen, int num_of_clusters,
+                      Matrix& centroids, ThreadPool* pool) const;
   void ExportCentroids();
+  // both recompute the cached squared norms and drop the KD-tree
   void MinMaxNormalization();  // min-max normalization
   void ZScoreNormalization();  // z-score normalization
 
-  std::vector<int> GetTrueLabels() { return true_labels_; }
+  const std::vector<int>& GetTrueLabels() const { return true_labels_; }
 };
 
 #endif  // DATA_H_
@@ -0,0 +1,564 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./dataset_io.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "../util/thread_pool.h"
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// files below this are parsed on the calling thread, starting the pool would
+// cost more than it saves
+static constexpr size_t kParallelLoadMinBytes = 1 << 20;
+
+static bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+static const char* SkipBlanks(const char* p, const char* end) {
+  while (p < end && IsBlank(*p)) p++;
+  return p;
+}
+
+static const char* LineEnd(const char* p, const char* end) {
+  const char* newline =
+      static_cast<const char*>(std::memchr(p, '\n', end - p));
+  return newline != nullptr ? newline : end;
+}
+
+// parses the next whitespace separated number of [p, end), false when there
+// is none or it is not a number of type T
+template <typename T>
+static bool ParseValue(const char*& p, const char* end, T& value) {
+  p = SkipBlanks(p, end);
+  if (p < end && *p == '+') p++;  // from_chars rejects an explicit plus
+  auto [next, error] = std::from_chars(p, end, value);
+  if (error != std::errc() || (next < end && !IsBlank(*next))) return false;
+  p = next;
+  return true;
+}
+
+// the header decides the layout, "n d" or "n d k" with labels, exits when it
+// is neither
+static void ParseTextHeader(const std::string& path, const char* p,
+                            const char* end, long long& num_of_points,
+                            long long& num_of_dimensions,
+                            long long& num_of_clusters, bool& has_labels) {
+  long long num_of_columns = 0;
+  num_of_clusters = 0;
+  bool valid = ParseValue(p, end, num_of_points) &&
+               ParseValue(p, end, num_of_columns) && num_of_points > 0 &&
+               num_of_columns > 0;
+  has_labels = valid && SkipBlanks(p, end) < end;
+  if (has_labels) {
+    valid = ParseValue(p, end, num_of_clusters) && SkipBlanks(p, end) == end;
+  }
+  if (!valid) {
+    std::cout << path << ":1: expected \"n d\" or \"n d k\" header"
+              << std::endl;
+    std::exit(1);
+  }
+  num_of_dimensions = num_of_columns - (has_labels ? 1 : 0);
+}
+
+namespace {
+
+// line-aligned slice of the file body, parsed by one thread
+struct TextChunk {
+  const char* begin_;
+  const char* end_;
+  size_t num_of_rows_ = 0;   // non-blank lines
+  size_t num_of_lines_ = 0;  // every line, for error messages
+  size_t first_row_ = 0;
+  size_t first_line_ = 0;
+  // first problem found, line 0 when the chunk parsed cleanly
+  size_t error_line_ = 0;
+  std::string error_;
+};
+
+}  // namespace
+
+// Maps the file, cuts the body into one line-aligned chunk per thread and
+// parses them in parallel with from_chars. A first pass counts the rows of
+// every chunk so each one knows which point and line number it starts at.
+void ReadTextDataset(const std::string& path, DatasetContents& contents) {
+  MappedFile file;
+  if (!file.Open(path)) {
+    std::cout << "File failed to open. PATH :: " << path << std::endl;
+    std::exit(1);
+  }
+
+  const char* data = file.Data();
+  const char* end = data + file.Size();
+
+  const char* header_end = LineEnd(data, end);
+  long long num_of_points = 0;
+  long long num_of_dimensions = 0;
+  long long num_of_clusters = 0;
+  bool has_labels = false;
+  ParseTextHeader(path, data, header_end, num_of_points, num_of_dimensions,
+                  num_of_clusters, has_labels);
+
+  contents.num_of_clusters_ = has_labels ? num_of_clusters : 0;
+  contents.points_.Resize(num_of_points, num_of_dimensions);
+  contents.labels_.assign(has_labels ? num_of_points : 0, 0);
+
+  const char* body = header_end < end ? header_end + 1 : end;
+
+  std::unique_ptr<ThreadPool> pool;
+  size_t num_of_chunks = 1;
+  if (static_cast<size_t>(end - body) >= kParallelLoadMinBytes) {
+    pool = std::make_unique<ThreadPool>(NUM_OF_THREADS);
+    num_of_chunks = pool->GetNumOfThreads();
+  }
+
+  std::vector<TextChunk> chunks(num_of_chunks);
+  const char* chunk_begin = body;
+  for (size_t c = 0; c < num_of_chunks; c++) {
+    const char* chunk_end = end;
+    if (c + 1 < num_of_chunks) {
+      chunk_end = body + (end - body) * (c + 1) / num_of_chunks;
+      chunk_end = std::max(chunk_end, chunk_begin);
+      chunk_end = chunk_end < end ? LineEnd(chunk_end, end) : end;
+      if (chunk_end < end) chunk_end++;
+    }
+    chunks[c].begin_ = chunk_begin;
+    chunks[c].end_ = chunk_end;
+    chunk_begin = chunk_end;
+  }
+
+  auto for_each_chunk = [&](const std::function<void(TextChunk&)>& fn) {
+    auto run = [&](size_t begin, size_t stop, int) {
+      for (size_t c = begin; c < stop; c++) fn(chunks[c]);
+    };
+    if (pool != nullptr) {
+      pool->ParallelFor(num_of_chunks, run);
+    } else {
+      run(0, num_of_chunks, 0);
+    }
+  };
+
+  for_each_chunk([](TextChunk& chunk) {
+    for (const char* line = chunk.begin_; line < chunk.end_;) {
+      const char* line_end = LineEnd(line, chunk.end_);
+      if (SkipBlanks(line, line_end) < line_end) chunk.num_of_rows_++;
+      chunk.num_of_lines_++;
+      line = line_end + 1;
+    }
+  });
+
+  size_t num_of_rows = 0;
+  size_t num_of_lines = 1;  // the header
+  for (TextChunk& chunk : chunks) {
+    chunk.first_row_ = num_of_rows;
+    chunk.first_line_ = num_of_lines + 1;
+    num_of_rows += chunk.num_of_rows_;
+    num_of_lines += chunk.num_of_lines_;
+  }
+
+  if (num_of_rows != static_cast<size_t>(num_of_points)) {
+    std::cout << path << ": header promises " << num_of_points
+              << " rows but the file has " << num_of_rows << std::endl;
+    std::exit(1);
+  }
+
+  for_each_chunk([&](TextChunk& chunk) {
+    size_t row = chunk.first_row_;
+    size_t line_number = chunk.first_line_;
+    for (const char* line = chunk.begin_; line < chunk.end_;
+         line_number++) {
+      const char* line_end = LineEnd(line, chunk.end_);
+      const char* cursor = line;
+      line = line_end + 1;
+      if (SkipBlanks(cursor, line_end) == line_end) continue;
+
+      double* point = contents.points_.Row(row);
+      for (long long j = 0; j < num_of_dimensions; j++) {
+        if (!ParseValue(cursor, line_end, point[j])) {
+          chunk.error_ = "expected " + std::to_string(num_of_dimensions) +
+                         " numeric features, bad or missing value " +
+                         std::to_string(j + 1);
+          chunk.error_line_ = line_number;
+          return;
+        }
+      }
+      if (has_labels && !ParseValue(cursor, line_end, contents.labels_[row])) {
+        chunk.error_ = "bad or missing integer label";
+        chunk.error_line_ = line_number;
+        return;
+      }
+      if (SkipBlanks(cursor, line_end) < line_end) {
+        chunk.error_ = "more values than the header declares";
+        chunk.error_line_ = line_number;
+        return;
+      }
+      row++;
+    }
+  });
+
+  // chunks are in file order, so the first error found is the earliest
+  for (const TextChunk& chunk : chunks) {
+    if (chunk.error_line_ != 0) {
+      std::cout << path << ":" << chunk.error_line_ << ": " << chunk.error_
+                << std::endl;
+      std::exit(1);
+    }
+  }
+}
+
+bool IsBinaryDataset(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kBinaryDatasetMagic)];
+  if (!file.read(magic, sizeof(magic))) return false;
+  return std::memcmp(magic, kBinaryDatasetMagic, sizeof(magic)) == 0;
+}
+
+std::string BinaryDatasetPath(const std::string& text_path) {
+  return std::filesystem::path(text_path).replace_extension(".bin").string();
+}
+
+std::string ResolveDatasetPath(const std::string& path, DataType dtype) {
+  std::string binary_path = BinaryDatasetPath(path);
+  if (binary_path == path) return path;
+
+  std::error_code error;
+  auto binary_time = std::filesystem::last_write_time(binary_path, error);
+  if (error) return path;
+  auto text_time = std::filesystem::last_write_time(path, error);
+  if (!error && binary_time < text_time) return path;
+
+  // a --float32 copy holds rounded points, a double run reading it would
+  // cluster different data than the text file has
+  BinaryDatasetHeader header;
+  std::ifstream file(binary_path, std::ios::binary);
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic_, kBinaryDatasetMagic,
+                  sizeof(kBinaryDatasetMagic)) != 0 ||
+      header.dtype_ != static_cast<uint32_t>(dtype)) {
+    return path;
+  }
+
+  return binary_path;
+}
+
+// exits unless header describes a dataset that fits in file_size bytes
+static void CheckBinaryHeader(const std::string& path,
+                              const BinaryDatasetHeader& header,
+                              uint64_t file_size) {
+  auto fail = [&](const char* reason) {
+    std::cout << path << ": invalid binary dataset, " << reason << std::endl;
+    std::exit(1);
+  };
+
+  if (std::memcmp(header.magic_, kBinaryDatasetMagic,
+                  sizeof(kBinaryDatasetMagic)) != 0) {
+    fail("bad magic");
+  }
+  if (header.version_ != kBinaryDatasetVersion) fail("unsupported version");
+  if (header.dtype_ >= static_cast<uint32_t>(DataType::COUNT)) {
+    fail("unknown dtype");
+  }
+  if (header.stride_ < header.num_of_dimensions_) fail("stride too small");
+
+  uint64_t value_size =
+      header.dtype_ == static_cast<uint32_t>(DataType::FLOAT32) ? 4 : 8;
+  uint64_t features_end = header.features_offset_ + header.num_of_points_ *
+                                                        header.stride_ *
+                                                        value_size;
+  if (features_end > file_size) fail("truncated features");
+  if (header.has_labels_ &&
+      header.labels_offset_ + header.num_of_points_ * sizeof(int32_t) >
+          file_size) {
+    fail("truncated labels");
+  }
+}
+
+const BinaryDatasetHeader& MapBinaryDataset(const std::string& path,
+                                            MappedFile& file) {
+  if (!file.Open(path)) {
+    std::cout << "File failed to open. PATH :: " << path << std::endl;
+    std::exit(1);
+  }
+
+  if (file.Size() < sizeof(BinaryDatasetHeader)) {
+    std::cout << path << ": invalid binary dataset, truncated header"
+              << std::endl;
+    std::exit(1);
+  }
+  const BinaryDatasetHeader& header =
+      *reinterpret_cast<const BinaryDatasetHeader*>(file.Data());
+  CheckBinaryHeader(path, header, file.Size());
+  return header;
+}
+
+void WriteBinaryDataset(const std::string& path,
+                        const DatasetContents& contents,
+                        NormalizationMethod normalization, DataType dtype) {
+  const Matrix& points = contents.points_;
+  bool has_labels = !contents.labels_.empty();
+
+  FloatMatrix float_points;
+  if (dtype == DataType::FLOAT32) {
+    float_points.Resize(points.Rows(), points.Cols());
+    for (size_t i = 0; i < points.Rows(); i++) {
+      std::copy(points[i].begin(), points[i].end(), float_points.Row(i));
+    }
+  }
+  const char* features =
+      dtype == DataType::FLOAT32
+          ? reinterpret_cast<const char*>(float_points.Data())
+          : reinterpret_cast<const char*>(points.Data());
+  size_t stride =
+      dtype == DataType::FLOAT32 ? float_points.Stride() : points.Stride();
+  size_t value_size = dtype == DataType::FLOAT32 ? sizeof(float) : 8;
+
+  BinaryDatasetHeader header = {};
+  std::memcpy(header.magic_, kBinaryDatasetMagic, sizeof(header.magic_));
+  header.version_ = kBinaryDatasetVersion;
+  header.dtype_ = static_cast<uint32_t>(dtype);
+  header.num_of_points_ = points.Rows();
+  header.num_of_dimensions_ = points.Cols();
+  header.stride_ = stride;
+  header.num_of_clusters_ = contents.num_of_clusters_;
+  header.has_labels_ = has_labels;
+  header.normalization_ = static_cast<uint32_t>(normalization);
+  header.features_offset_ =
+      AlignUp(sizeof(BinaryDatasetHeader), ROW_ALIGNMENT_BYTES);
+  header.labels_offset_ =
+      header.features_offset_ + points.Rows() * stride * value_size;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    std::cout << "File failed to open. PATH :: " << path << std::endl;
+    std::exit(1);
+  }
+
+  std::vector<char> padding(header.features_offset_ - sizeof(header), 0);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(padding.data(), padding.size());
+  file.write(features, points.Rows() * stride * value_size);
+
+  if (has_labels) {
+    std::vector<int32_t> labels(contents.labels_.begin(),
+                                contents.labels_.end());
+    file.write(reinterpret_cast<const char*>(labels.data()),
+               labels.size() * sizeof(int32_t));
+  }
+
+  if (!file) {
+    std::cout << "Failed writing " << path << std::endl;
+    std::exit(1);
+  }
+}
+
+DatasetReader::DatasetReader(const std::string& path) : path_(path) {
+  binary_ = IsBinaryDataset(path);
+  file_.open(path, std::ios::binary);
+  if (!file_.is_open()) {
+    std::cout << "File failed to open. PATH :: " << path << std::endl;
+    std::exit(1);
+  }
+
+  if (binary_) {
+    std::error_code error;
+    uint64_t file_size = std::filesystem::file_size(path, error);
+    if (error || !file_.read(reinterpret_cast<char*>(&header_),
+                             sizeof(header_))) {
+      std::cout << path << ": invalid binary dataset, truncated header"
+                << std::endl;
+      std::exit(1);
+    }
+    CheckBinaryHeader(path, header_, file_size);
+
+    num_of_points_ = header_.num_of_points_;
+    num_of_dimensions_ = header_.num_of_dimensions_;
+    num_of_clusters_ = static_cast<int>(header_.num_of_clusters_);
+    has_labels_ = header_.has_labels_ != 0;
+    if (header_.normalization_ <
+        static_cast<uint32_t>(NormalizationMethod::COUNT)) {
+      stored_normalization_ =
+          static_cast<NormalizationMethod>(header_.normalization_);
+    }
+  } else {
+    if (!std::getline(file_, line_)) {
+      std::cout << path << ":1: expected \"n d\" or \"n d k\" header"
+                << std::endl;
+      std::exit(1);
+    }
+    long long num_of_points = 0;
+    long long num_of_dimensions = 0;
+    long long num_of_clusters = 0;
+    ParseTextHeader(path, line_.data(), line_.data() + line_.size(),
+                    num_of_points, num_of_dimensions, num_of_clusters,
+                    has_labels_);
+    num_of_points_ = num_of_points;
+    num_of_dimensions_ = num_of_dimensions;
+    num_of_clusters_ = static_cast<int>(num_of_clusters);
+    body_start_ = file_.tellg();
+  }
+}
+
+void DatasetReader::Rewind() {
+  next_row_ = 0;
+  file_.clear();
+  if (!binary_) {
+    file_.seekg(body_start_);
+    line_number_ = 1;
+  }
+}
+
+size_t DatasetReader::Read(Matrix& points, int* labels) {
+  if (points.Cols() != num_of_dimensions_) {
+    std::cout << path_ << ": read into a matrix of " << points.Cols()
+              << " columns, the dataset has " << num_of_dimensions_
+              << std::endl;
+    std::exit(1);
+  }
+  size_t rows = std::min(points.Rows(), num_of_points_ - next_row_);
+  if (rows == 0) return 0;
+
+  rows = binary_ ? ReadBinary(points, rows, labels)
+                 : ReadText(points, rows, labels);
+  next_row_ += rows;
+  return rows;
+}
+
+size_t DatasetReader::ReadBinary(Matrix& points, size_t rows, int* labels) {
+  bool float32 = header_.dtype_ == static_cast<uint32_t>(DataType::FLOAT32);
+  size_t value_size = float32 ? sizeof(float) : sizeof(double);
+  size_t row_bytes = header_.stride_ * value_size;
+
+  buffer_.resize(rows * row_bytes);
+  file_.seekg(header_.features_offset_ + next_row_ * row_bytes);
+  if (!file_.read(buffer_.data(), buffer_.size())) {
+    std::cout << "Failed reading " << path_ << std::endl;
+    std::exit(1);
+  }
+
+  // the file's stride is that of its own value type, rows are copied one by
+  // one into the double matrix
+  for (size_t r = 0; r < rows; r++) {
+    const char* row = buffer_.data() + r * row_bytes;
+    double* point = points.Row(r);
+    if (float32) {
+      const float* values = reinterpret_cast<const float*>(row);
+      std::copy_n(values, num_of_dimensions_, point);
+    } else {
+      std::memcpy(point, row, num_of_dimensions_ * sizeof(double));
+    }
+  }
+
+  if (labels != nullptr && has_labels_) {
+    std::vector<int32_t> stored(rows);
+    file_.seekg(header_.labels_offset_ + next_row_ * sizeof(int32_t));
+    if (!file_.read(reinterpret_cast<char*>(stored.data()),
+                    rows * sizeof(int32_t))) {
+      std::cout << "Failed reading " << path_ << std::endl;
+      std::exit(1);
+    }
+    std::copy(stored.begin(), stored.end(), labels);
+  }
+  return rows;
+}
+
+size_t DatasetReader::ReadText(Matrix& points, size_t rows, int* labels) {
+  size_t row = 0;
+  while (row < rows) {
+    if (!std::getline(file_, line_)) {
+      std::cout << path_ << ": header promises " << num_of_points_
+                << " rows but the file has " << next_row_ + row << std::endl;
+      std::exit(1);
+    }
+    line_number_++;
+    const char* cursor = line_.data();
+    const char* line_end = cursor + line_.size();
+    if (SkipBlanks(cursor, line_end) == line_end) continue;
+
+    auto fail = [&](const std::string& reason) {
+      std::cout << path_ << ":" << line_number_ << ": " << reason
+                << std::endl;
+      std::exit(1);
+    };
+
+    double* point = points.Row(row);
+    for (size_t j = 0; j < num_of_dimensions_; j++) {
+      if (!ParseValue(cursor, line_end, point[j])) {
+        fail("expected " + std::to_string(num_of_dimensions_) +
+             " numeric features, bad or missing value " +
+             std::to_string(j + 1));
+      }
+    }
+    int label = 0;
+    if (has_labels_ && !ParseValue(cursor, line_end, label)) {
+      fail("bad or missing integer label");
+    }
+    if (SkipBlanks(cursor, line_end) < line_end) {
+      fail("more values than the header declares");
+    }
+    if (labels != nullptr && has_labels_) labels[row] = label;
+    row++;
+  }
+  return rows;
+}
+
+void MinMaxNormalize(Matrix& points) {
+  size_t num_of_points = points.Rows();
+  size_t num_of_dimensions = points.Cols();
+  if (num_of_points == 0) return;
+
+  for (size_t j = 0; j < num_of_dimensions; j++) {
+    double min_val = points[0][j];
+    double max_val = points[0][j];
+    for (size_t i = 1; i < num_of_points; i++) {
+      min_val = std::min(min_val, points[i][j]);
+      max_val = std::max(max_val, points[i][j]);
+    }
+
+    double range = max_val - min_val;
+
+    range = std::max(range, 1e-9);  // prevent division by zero
+
+    for (size_t i = 0; i < num_of_points; i++) {
+      points[i][j] = (points[i][j] - min_val) / range;
+    }
+  }
+}
+
+void ZScoreNormalize(Matrix& points) {
+  size_t num_of_points = points.Rows();
+  size_t num_of_dimensions = points.Cols();
+  if (num_of_points == 0) return;
+
+  for (size_t i = 0; i < num_of_dimensions; i++) {
+    double mean = 0.0;
+    for (size_t j = 0; j < num_of_points; j++) {
+      mean += points[j][i];
+    }
+    mean /= num_of_points;
+
+    double sum = 0.0;
+    for (size_t j = 0; j < num_of_points; j++) {
+      double diff = points[j][i] - mean;
+      sum += diff * diff;
+    }
+
+    double stdev = std::max(sqrt(sum), 1e-9);
+
+    for (size_t j = 0; j < num_of_points; j++) {
+      points[j][i] = (points[j][i] - mean) / stdev;
+    }
+  }
+}
@@ -0,0 +1,136 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef DATASET_IO_H_
+#define DATASET_IO_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../util/config.h"
+#include "../util/mapped_file.h"
+#include "./matrix.h"
+
+/*
+Binary dataset format, written by convert_dataset and memory mapped by Data
+
+  BinaryDatasetHeader, padded to features_offset_
+  features, num_of_points_ rows of stride_ values, zero padded like Matrix
+  labels, num_of_points_ int32 values at labels_offset_ when has_labels_
+
+Integers are stored in the byte order of the machine that wrote the file.
+Features start on a ROW_ALIGNMENT_BYTES boundary and rows use the Matrix
+stride, so a mapped file is used in place as the point matrix.
+*/
+
+inline constexpr char kBinaryDatasetMagic[8] = {'D', 'C', 'L', 'U',
+                                                'S', 'T', 'B', '\0'};
+inline constexpr uint32_t kBinaryDatasetVersion = 1;
+
+enum class DataType : uint32_t { FLOAT64 = 0, FLOAT32 = 1, COUNT };
+
+struct BinaryDatasetHeader {
+  char magic_[8];
+  uint32_t version_;
+  uint32_t dtype_;  // DataType
+  uint64_t num_of_points_;
+  uint64_t num_of_dimensions_;
+  uint64_t stride_;
+  int64_t num_of_clusters_;  // 0 when the source did not give one
+  uint32_t has_labels_;
+  // NormalizationMethod already applied to the features, COUNT for raw data
+  uint32_t normalization_;
+  uint64_t features_offset_;
+  uint64_t labels_offset_;
+};
+
+// Points, true labels (empty when the file has none) and cluster count
+// (0 when the file has none) as stored in a dataset file
+struct DatasetContents {
+  Matrix points_;
+  std::vector<int> labels_;
+  int num_of_clusters_ = 0;
+};
+
+// Text datasets come in two layouts:
+//   "n d" header, then n rows of d features
+//   "n d k" header, then n rows of d - 1 features and a label
+void ReadTextDataset(const std::string& path, DatasetContents& contents);
+
+bool IsBinaryDataset(const std::string& path);
+
+// path of the binary copy of a text dataset (same name, .bin extension)
+std::string BinaryDatasetPath(const std::string& text_path);
+
+// the binary copy of path when one exists, is at least as new as it and
+// stores dtype values, otherwise path itself
+std::string ResolveDatasetPath(const std::string& path,
+                               DataType dtype = DataType::FLOAT64);
+
+// maps the file into file and returns its validated header, the features
+// and labels point into the mapping
+const BinaryDatasetHeader& MapBinaryDataset(const std::string& path,
+                                            MappedFile& file);
+
+// FLOAT32 files halve the size, Data widens them to double on load and can
+// use them directly as its single precision copy
+void WriteBinaryDataset(const std::string& path,
+                        const DatasetContents& contents,
+                        NormalizationMethod normalization,
+                        DataType dtype = DataType::FLOAT64);
+
+// Reads a text or binary dataset a block of rows at a time, for datasets too
+// large to load. Binary files are read rather than mapped, so only the block
+// being read is resident. Errors exit with a message like ReadTextDataset.
+class DatasetReader {
+ private:
+  std::string path_;
+  std::ifstream file_;
+  bool binary_ = false;
+  size_t num_of_points_ = 0;
+  size_t num_of_dimensions_ = 0;
+  int num_of_clusters_ = 0;
+  bool has_labels_ = false;
+  NormalizationMethod stored_normalization_ = NormalizationMethod::COUNT;
+  size_t next_row_ = 0;
+
+  // binary layout
+  BinaryDatasetHeader header_ = {};
+  std::vector<char> buffer_;
+  // text position, the stream offset of the first row and its line number
+  std::streampos body_start_;
+  size_t line_number_ = 1;
+  std::string line_;
+
+  size_t ReadBinary(Matrix& points, size_t rows, int* labels);
+  size_t ReadText(Matrix& points, size_t rows, int* labels);
+
+ public:
+  explicit DatasetReader(const std::string& path);
+
+  size_t NumOfPoints() const { return num_of_points_; }
+  size_t NumOfDimensions() const { return num_of_dimensions_; }
+  // 0 when the file does not give one
+  int NumOfClusters() const { return num_of_clusters_; }
+  bool HasLabels() const { return has_labels_; }
+  // normalization a binary file's features already carry, COUNT otherwise
+  NormalizationMethod StoredNormalization() const {
+    return stored_normalization_;
+  }
+
+  // back to the first row
+  void Rewind();
+  // reads the next rows into the rows of points (its shape must match the
+  // dataset's dimensions) and their true labels into labels when it is not
+  // nullptr, returns how many were read, 0 once every row has been
+  size_t Read(Matrix& points, int* labels = nullptr);
+};
+
+void MinMaxNormalize(Matrix& points);
+void ZScoreNormalize(Matrix& points);
+
+#endif  // DATASET_IO_H_
@@ -0,0 +1,94 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./kd_tree.h"
+
+#include <algorithm>
+#include <limits>
+
+KdTree::KdTree(const Matrix& points, const std::vector<double>& squared_norms,
+               int leaf_size) {
+  int num_of_points = static_cast<int>(points.Rows());
+  if (num_of_points == 0) return;
+
+  indices_.resize(num_of_points);
+  for (int i = 0; i < num_of_points; i++) indices_[i] = i;
+
+  // boxes and sums are collected flat while the node count is unknown
+  std::vector<double> lower;
+  std::vector<double> upper;
+  std::vector<double> sums;
+  Build(points, squared_norms, 0, num_of_points, std::max(leaf_size, 1),
+        lower, upper, sums);
+
+  size_t num_of_dimensions = points.Cols();
+  points_.Resize(num_of_points, num_of_dimensions);
+  for (int i = 0; i < num_of_points; i++) {
+    std::copy_n(points.Row(indices_[i]), num_of_dimensions, points_.Row(i));
+  }
+
+  lower_.Resize(nodes_.size(), num_of_dimensions);
+  upper_.Resize(nodes_.size(), num_of_dimensions);
+  sums_.Resize(nodes_.size(), num_of_dimensions);
+  for (size_t node = 0; node < nodes_.size(); node++) {
+    size_t offset = node * num_of_dimensions;
+    std::copy_n(&lower[offset], num_of_dimensions, lower_.Row(node));
+    std::copy_n(&upper[offset], num_of_dimensions, upper_.Row(node));
+    std::copy_n(&sums[offset], num_of_dimensions, sums_.Row(node));
+  }
+}
+
+int KdTree::Build(const Matrix& points,
+                  const std::vector<double>& squared_norms, int begin,
+                  int end, int leaf_size, std::vector<double>& lower,
+                  std::vector<double>& upper, std::vector<double>& sums) {
+  size_t num_of_dimensions = points.Cols();
+  int node = static_cast<int>(nodes_.size());
+  nodes_.push_back({begin, end, -1, -1, 0.0});
+
+  size_t offset = lower.size();
+  lower.resize(offset + num_of_dimensions,
+               std::numeric_limits<double>::max());
+  upper.resize(offset + num_of_dimensions,
+               std::numeric_limits<double>::lowest());
+  sums.resize(offset + num_of_dimensions, 0.0);
+
+  double squared_norm_sum = 0.0;
+  for (int i = begin; i < end; i++) {
+    const double* point = points.Row(indices_[i]);
+    for (size_t j = 0; j < num_of_dimensions; j++) {
+      lower[offset + j] = std::min(lower[offset + j], point[j]);
+      upper[offset + j] = std::max(upper[offset + j], point[j]);
+      sums[offset + j] += point[j];
+    }
+    squared_norm_sum += squared_norms[indices_[i]];
+  }
+  nodes_[node].squared_norm_sum_ = squared_norm_sum;
+
+  size_t widest = 0;
+  double width = 0.0;
+  for (size_t j = 0; j < num_of_dimensions; j++) {
+    if (upper[offset + j] - lower[offset + j] > width) {
+      width = upper[offset + j] - lower[offset + j];
+      widest = j;
+    }
+  }
+  // a cell of identical points cannot be split
+  if (end - begin <= leaf_size || width == 0.0) return node;
+
+  int middle = begin + (end - begin) / 2;
+  std::nth_element(indices_.begin() + begin, indices_.begin() + middle,
+                   indices_.begin() + end, [&points, widest](int a, int b) {
+                     return points.Row(a)[widest] < points.Row(b)[widest];
+                   });
+
+  int left = Build(points, squared_norms, begin, middle, leaf_size, lower,
+                   upper, sums);
+  int right = Build(points, squared_norms, middle, end, leaf_size, lower,
+                    upper, sums);
+  nodes_[node].left_ = left;
+  nodes_[node].right_ = right;
+  return node;
+}
@@ -0,0 +1,63 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef KD_TREE_H_
+#define KD_TREE_H_
+
+#include <vector>
+
+#include "../util/config.h"
+#include "./matrix.h"
+
+// KD-tree over a point matrix for the filtering k-means engine. Each node
+// covers a contiguous range of Indices() and stores the bounding box, sum,
+// count and summed squared norm of its points, so a whole cell can be handed
+// to one centroid without visiting its points. Cells are split at the median
+// of their widest dimension. Node 0 is the root and every node's left child
+// directly follows it.
+class KdTree {
+ public:
+  struct Node {
+    int begin_;  // points Indices()[begin_, end_) lie in this cell
+    int end_;
+    int left_;  // -1 on leaves
+    int right_;
+    double squared_norm_sum_;  // sum of ||x||^2 over the cell
+  };
+
+ private:
+  std::vector<Node> nodes_;
+  std::vector<int> indices_;
+  // copy of the points in Indices() order, so the points of a cell are
+  // contiguous rows
+  Matrix points_;
+  // one row per node
+  Matrix lower_;
+  Matrix upper_;
+  Matrix sums_;
+
+  int Build(const Matrix& points, const std::vector<double>& squared_norms,
+            int begin, int end, int leaf_size, std::vector<double>& lower,
+            std::vector<double>& upper, std::vector<double>& sums);
+
+ public:
+  KdTree() = default;
+  KdTree(const Matrix& points, const std::vector<double>& squared_norms,
+         int leaf_size = KD_TREE_LEAF_SIZE);
+
+  bool Empty() const { return nodes_.empty(); }
+  size_t NumOfNodes() const { return nodes_.size(); }
+  const Node& GetNode(int node) const { return nodes_[node]; }
+  const std::vector<int>& Indices() const { return indices_; }
+  // row i is the point Indices()[i]
+  const Matrix& Points() const { return points_; }
+  const double* Lower(int node) const { return lower_.Row(node); }
+  const double* Upper(int node) const { return upper_.Row(node); }
+  const double* Sum(int node) const { return sums_.Row(node); }
+  // rows of Lower(), Upper() and Sum() are this many values apart
+  size_t Stride() const { return sums_.Stride(); }
+};
+
+#endif  // KD_TREE_H_
@@ -0,0 +1,163 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef MATRIX_H_
+#define MATRIX_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <span>
+
+#include "../util/config.h"
+
+// Dense row-major n x d matrix of T stored in a single aligned buffer. Each
+// row is padded with zeros up to a multiple of ROW_ALIGNMENT_BYTES so that
+// every row starts on an aligned boundary and SIMD kernels can run over
+// Stride() elements without a remainder loop.
+//
+// A matrix can also be a view over memory it does not own (a memory mapped
+// dataset), copies of a view always own their buffer.
+template <typename T>
+class BasicMatrix {
+ private:
+  T* data_ = nullptr;
+  size_t rows_ = 0;
+  size_t cols_ = 0;
+  size_t stride_ = 0;
+  bool owns_data_ = true;
+
+  static constexpr size_t kAlignment = ROW_ALIGNMENT_BYTES;
+
+  void Allocate() {
+    owns_data_ = true;
+    size_t bytes = rows_ * stride_ * sizeof(T);
+    if (bytes == 0) {
+      data_ = nullptr;
+      return;
+    }
+    data_ = static_cast<T*>(
+        ::operator new(bytes, std::align_val_t(kAlignment)));
+    std::fill(data_, data_ + rows_ * stride_, T(0));
+  }
+
+  void Release() {
+    if (data_ != nullptr && owns_data_) {
+      ::operator delete(data_, std::align_val_t(kAlignment));
+    }
+    data_ = nullptr;
+  }
+
+ public:
+  BasicMatrix() = default;
+
+  BasicMatrix(size_t rows, size_t cols)
+      : rows_(rows), cols_(cols), stride_(PaddedStride(cols)) {
+    Allocate();
+  }
+
+  // view over rows x stride values owned elsewhere, data must be aligned to
+  // ROW_ALIGNMENT_BYTES and outlive the matrix
+  BasicMatrix(T* data, size_t rows, size_t cols, size_t stride)
+      : data_(data),
+        rows_(rows),
+        cols_(cols),
+        stride_(stride),
+        owns_data_(false) {}
+
+  BasicMatrix(const BasicMatrix& other)
+      : rows_(other.rows_), cols_(other.cols_), stride_(other.stride_) {
+    Allocate();
+    if (data_ != nullptr) {
+      std::copy(other.data_, other.data_ + rows_ * stride_, data_);
+    }
+  }
+
+  BasicMatrix(BasicMatrix&& other) noexcept
+      : data_(other.data_),
+        rows_(other.rows_),
+        cols_(other.cols_),
+        stride_(other.stride_),
+        owns_data_(other.owns_data_) {
+    other.data_ = nullptr;
+    other.rows_ = other.cols_ = other.stride_ = 0;
+  }
+
+  BasicMatrix& operator=(const BasicMatrix& other) {
+    if (this == &other) return *this;
+    if (!owns_data_ || rows_ * stride_ != other.rows_ * other.stride_) {
+      Release();
+      rows_ = other.rows_;
+      stride_ = other.stride_;
+      Allocate();
+    }
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    stride_ = other.stride_;
+    if (data_ != nullptr) {
+      std::copy(other.data_, other.data_ + rows_ * stride_, data_);
+    }
+    return *this;
+  }
+
+  BasicMatrix& operator=(BasicMatrix&& other) noexcept {
+    if (this == &other) return *this;
+    Release();
+    data_ = other.data_;
+    rows_ = other.rows_;
+    cols_ = other.cols_;
+    stride_ = other.stride_;
+    owns_data_ = other.owns_data_;
+    other.data_ = nullptr;
+    other.rows_ = other.cols_ = other.stride_ = 0;
+    return *this;
+  }
+
+  ~BasicMatrix() { Release(); }
+
+  // zeroes the buffer, previous contents are discarded. The buffer is only
+  // reallocated when the shape changes, so scratch matrices resized to the
+  // same shape every restart do not touch the heap.
+  void Resize(size_t rows, size_t cols) {
+    if (owns_data_ && data_ != nullptr && rows == rows_ && cols == cols_) {
+      std::fill(data_, data_ + rows_ * stride_, T(0));
+      return;
+    }
+    Release();
+    rows_ = rows;
+    cols_ = cols;
+    stride_ = PaddedStride(cols);
+    Allocate();
+  }
+
+  // row length in elements once padded for a matrix with cols columns
+  static size_t PaddedStride(size_t cols) {
+    constexpr size_t per_line = std::max<size_t>(1, kAlignment / sizeof(T));
+    return (cols + per_line - 1) / per_line * per_line;
+  }
+
+  size_t Rows() const { return rows_; }
+  size_t Cols() const { return cols_; }
+  size_t Stride() const { return stride_; }
+  bool Empty() const { return rows_ == 0; }
+  bool OwnsData() const { return owns_data_; }
+
+  T* Data() { return data_; }
+  const T* Data() const { return data_; }
+
+  T* Row(size_t i) { return data_ + i * stride_; }
+  const T* Row(size_t i) const { return data_ + i * stride_; }
+
+  // views exclude the padding so they can be compared against other rows
+  std::span<T> operator[](size_t i) { return {Row(i), cols_}; }
+  std::span<const T> operator[](size_t i) const {
+    return {Row(i), cols_};
+  }
+};
+
+using Matrix = BasicMatrix<double>;
+using FloatMatrix = BasicMatrix<float>;
+
+#endif  // MATRIX_H_
@@ -5,60 +5,136 @@
 
 #include "./external_val.h"
 
-ExternalValidation::ExternalValidation() {}
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
 
-double ExternalValidation::RandIndex(const std::vector<int>& true_labels,
-                                     const std::vector<int>& predicted_labels) {
-  int same_cluster = 0;
-  int different_cluster = 0;
-
-  size_t n = true_labels.size();
-
-  for (size_t i = 0; i < n; i++) {
-    for (size_t j = i + 1; j < n; j++) {
-      if (true_labels[i] == true_labels[j] &&
-          predicted_labels[i] == predicted_labels[j]) {
-        same_cluster++;
-      } else if (true_labels[i] != true_labels[j] &&
-                 predicted_labels[i] != predicted_labels[j]) {
-        different_cluster++;
-      }
-    }
+// maps arbitrary label values to 0..count-1 in order of first appearance
+static std::vector<int> CompactLabels(const std::vector<int>& labels,
+                                      int& count) {
+  std::unordered_map<int, int> ids;
+  std::vector<int> compact(labels.size());
+  for (size_t i = 0; i < labels.size(); i++) {
+    auto [it, inserted] = ids.try_emplace(labels[i], ids.size());
+    compact[i] = it->second;
   }
+  count = static_cast<int>(ids.size());
+  return compact;
+}
 
-  double rand_index = static_cast<double>(same_cluster + different_cluster) /
-                      static_cast<double>(n * (n - 1) / 2);
+static long long PairsOf(long long count) { return count * (count - 1) / 2; }
 
-  return rand_index;
-}
+ExternalValidation::ExternalValidation() {}
 
-double ExternalValidation::JaccardIndex(
+ExternalScores ExternalValidation::Evaluate(
     const std::vector<int>& true_labels,
     const std::vector<int>& predicted_labels) {
-  int m11 = 0;  // both in same cluster
-  int m10 = 0;  // true same, predicted different
-  int m01 = 0;  // true different, predicted same
-
   size_t n = true_labels.size();
+  if (predicted_labels.size() != n) {
+    std::cerr << "ERROR :: Label vectors are of different sizes." << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
 
+  int num_of_classes;
+  int num_of_clusters;
+  std::vector<int> classes = CompactLabels(true_labels, num_of_classes);
+  std::vector<int> clusters = CompactLabels(predicted_labels, num_of_clusters);
+
+  // contingency[class * num_of_clusters + cluster]
+  std::vector<long long> contingency(
+      static_cast<size_t>(num_of_classes) * num_of_clusters, 0);
+  std::vector<long long> class_sizes(num_of_classes, 0);
+  std::vector<long long> cluster_sizes(num_of_clusters, 0);
   for (size_t i = 0; i < n; i++) {
-    for (size_t j = i + 1; j < n; j++) {
-      if (true_labels[i] == true_labels[j] &&
-          predicted_labels[i] == predicted_labels[j]) {
-        m11++;
-      } else if (true_labels[i] == true_labels[j] &&
-                 predicted_labels[i] != predicted_labels[j]) {
-        m10++;
-      } else if (true_labels[i] != true_labels[j] &&
-                 predicted_labels[i] == predicted_labels[j]) {
-        m01++;
-      }
-    }
+    contingency[static_cast<size_t>(classes[i]) * num_of_clusters +
+                clusters[i]]++;
+    class_sizes[classes[i]]++;
+    cluster_sizes[clusters[i]]++;
   }
 
+  long long m11 = 0;  // both in same cluster
+  for (long long cell : contingency) m11 += PairsOf(cell);
+  long long true_pairs = 0;  // same class
+  for (long long size : class_sizes) true_pairs += PairsOf(size);
+  long long predicted_pairs = 0;  // same cluster
+  for (long long size : cluster_sizes) predicted_pairs += PairsOf(size);
+
+  long long total_pairs = PairsOf(static_cast<long long>(n));
+  long long m10 = true_pairs - m11;       // true same, predicted different
+  long long m01 = predicted_pairs - m11;  // true different, predicted same
+  long long m00 = total_pairs - m11 - m10 - m01;
+
+  ExternalScores scores;
+  scores.rand_index_ =
+      total_pairs > 0
+          ? static_cast<double>(m11 + m00) / static_cast<double>(total_pairs)
+          : 1.0;
+
   double denom = static_cast<double>(m11 + m10 + m01);
   if (denom == 0) {
     denom = 1e-9;
   }
-  return static_cast<double>(m11) / denom;
-}
\ No newline at end of file
+  scores.jaccard_index_ = static_cast<double>(m11) / denom;
+
+  // ARI = (index - expected index) / (max index - expected index)
+  double expected = total_pairs > 0 ? static_cast<double>(true_pairs) *
+                                          static_cast<double>(predicted_pairs) /
+                                          static_cast<double>(total_pairs)
+                                    : 0.0;
+  double max_index =
+      0.5 * static_cast<double>(true_pairs + predicted_pairs);
+  scores.adjusted_rand_index_ =
+      max_index != expected
+          ? (static_cast<double>(m11) - expected) / (max_index - expected)
+          : 1.0;
+
+  double fm_denom = std::sqrt(static_cast<double>(true_pairs) *
+                              static_cast<double>(predicted_pairs));
+  scores.fowlkes_mallows_index_ =
+      fm_denom > 0.0 ? static_cast<double>(m11) / fm_denom : 0.0;
+
+  // NMI = I(U, V) / ((H(U) + H(V)) / 2)
+  double total = static_cast<double>(n);
+  double mutual_information = 0.0;
+  for (int u = 0; u < num_of_classes; u++) {
+    for (int v = 0; v < num_of_clusters; v++) {
+      long long cell =
+          contingency[static_cast<size_t>(u) * num_of_clusters + v];
+      if (cell == 0) continue;
+      double joint = static_cast<double>(cell);
+      mutual_information +=
+          joint / total *
+          std::log(joint * total / (static_cast<double>(class_sizes[u]) *
+                                    static_cast<double>(cluster_sizes[v])));
+    }
+  }
+  auto entropy = [total](const std::vector<long long>& sizes) {
+    double h = 0.0;
+    for (long long size : sizes) {
+      if (size == 0) continue;
+      double p = static_cast<double>(size) / total;
+      h -= p * std::log(p);
+    }
+    return h;
+  };
+  double mean_entropy = 0.5 * (entropy(class_sizes) + entropy(cluster_sizes));
+  // two single-cluster labelings agree completely
+  scores.normalized_mutual_information_ =
+      mean_entropy > 0.0 ? std::max(0.0, mutual_information) / mean_entropy
+                         : 1.0;
+
+  return scores;
+}
+
+double ExternalValidation::RandIndex(const std::vector<int>& true_labels,
+                                     const std::vector<int>& predicted_labels) {
+  return Evaluate(true_labels, predicted_labels).rand_index_;
+}
+
+double ExternalValidation::JaccardIndex(
+    const std::vector<int>& true_labels,
+    const std::vector<int>& predicted_labels) {
+  return Evaluate(true_labels, predicted_labels).jaccard_index_;
+}
@@ -6,13 +6,51 @@
 #ifndef EXTERNAL_VAL_H_
 #define EXTERNAL_VAL_H_
 
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 #include <vector>
 
+// Agreement of one labeling with the true labels, all derived from the same
+// contingency table. Defaults are the lowest double so any evaluated scores
+// replace them in KeepHighestScores.
+struct ExternalScores {
+  double rand_index_ = std::numeric_limits<double>::lowest();
+  double jaccard_index_ = std::numeric_limits<double>::lowest();
+  double adjusted_rand_index_ = std::numeric_limits<double>::lowest();
+  // arithmetic mean normalization
+  double normalized_mutual_information_ = std::numeric_limits<double>::lowest();
+  double fowlkes_mallows_index_ = std::numeric_limits<double>::lowest();
+};
+
+// per score maximum, each score is kept from whichever run scored it best
+inline void KeepHighestScores(const ExternalScores& scores,
+                              ExternalScores& highest) {
+  highest.rand_index_ = std::max(highest.rand_index_, scores.rand_index_);
+  highest.jaccard_index_ =
+      std::max(highest.jaccard_index_, scores.jaccard_index_);
+  highest.adjusted_rand_index_ =
+      std::max(highest.adjusted_rand_index_, scores.adjusted_rand_index_);
+  highest.normalized_mutual_information_ =
+      std::max(highest.normalized_mutual_information_,
+               scores.normalized_mutual_information_);
+  highest.fowlkes_mallows_index_ =
+      std::max(highest.fowlkes_mallows_index_, scores.fowlkes_mallows_index_);
+}
+
+// The pair counting indices are computed from the true x predicted
+// contingency table instead of visiting all n(n-1)/2 pairs: the pairs that
+// agree in both labelings are sum C(n_ij, 2) over its cells, the pairs
+// together in one labeling the same sum over its row or column totals. One
+// O(n + k*c) pass, counts are 64 bit so large datasets do not overflow.
 class ExternalValidation {
  private:
  public:
   ExternalValidation();
 
+  ExternalScores Evaluate(const std::vector<int>& true_labels,
+                          const std::vector<int>& predicted_labels);
+
   double RandIndex(const std::vector<int>& true_labels,
                    const std::vector<int>& predicted_labels);
 
@@ -20,4 +58,4 @@ class ExternalValidation {
                       const std::vector<int>& predicted_labels);
 };
 
-#endif  // EXTERNAL_VAL_H_
\ No newline at end of file
+#endif  // EXTERNAL_VAL_H_
@@ -29,17 +29,23 @@ int main() {
 
   original_cout_buf = std::cout.rdbuf(output_stream.rdbuf());
 
-  std::cout << "Dataset,Rand Index,Jaccard Index" << std::endl;
+  std::cout << "Dataset,Rand Index,Jaccard Index,Adjusted Rand Index,"
+               "Normalized Mutual Information,Fowlkes-Mallows Index"
+            << std::endl;
 
   for (size_t i = 0; i < data.size(); i++) {
     k_means = new K_Means(data[i], InitializationMethod::RANDOM_SELECTION);
+    k_means->SetAlgorithm(CLUSTERING_ALGORITHM);
+    k_means->SetBatchSize(MINI_BATCH_SIZE);
+    k_means->SetPrecision(CLUSTERING_PRECISION);
     k_means->Run();
 
-    double rand_index = k_means->GetRandIndex();
-    double jaccard_index = k_means->GetJaccardIndex();
+    const ExternalScores& scores = k_means->GetExternalScores();
 
-    std::cout << data[i]->GetFileName() << "," << rand_index << ","
-              << jaccard_index << std::endl;
+    std::cout << data[i]->GetFileName() << "," << scores.rand_index_ << ","
+              << scores.jaccard_index_ << "," << scores.adjusted_rand_index_
+              << "," << scores.normalized_mutual_information_ << ","
+              << scores.fowlkes_mallows_index_ << std::endl;
   }
 
   std::cout.rdbuf(original_cout_buf);
@@ -29,17 +29,21 @@ centroids will be close to the mean of the points, which will effectively push
 centroids apart to well representative clusters.
 */
 
-#include <chrono>
+#include <algorithm>
 #include <ctime>
 #include <filesystem>  // technically unapproved by google standards
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "./algo/k_means.h"
 #include "./data/data.h"
 #include "./util/config.h"
+#include "./util/work_stealing_pool.h"
 
 Data *ReadArgs(int argc, char *argv[]) {
   if (argc != 6) {
@@ -93,6 +97,64 @@ std::vector<Data *> ReadDatasets() {
   return datasets;
 }
 
+// Clusters every dataset / normalization / initialization combination, one
+// K_Means per job. Jobs only read their Data, so they run side by side on a
+// work stealing pool, the most expensive (n * d * k * runs) first so the
+// longest job is never the one left running alone at the end. Each job
+// writes its row to its own slot and rows are printed in grid order once
+// all jobs are done, so the CSV does not depend on completion order.
+void RunGrid(const std::vector<Data *> &datasets) {
+  struct Job {
+    Data *data_;
+    InitializationMethod initialization_method_;
+    double cost_;
+    std::string row_;
+  };
+
+  std::vector<Job> jobs;
+  for (Data *data : datasets) {
+    double cost = static_cast<double>(data->GetNumOfPoints()) *
+                  data->GetNumOfDimensions() * data->GetNumOfClusters() *
+                  data->GetNumOfRuns();
+    for (int init_method = 0;
+         init_method < static_cast<int>(InitializationMethod::COUNT);
+         init_method++) {
+      jobs.push_back(
+          {data, static_cast<InitializationMethod>(init_method), cost, ""});
+    }
+  }
+
+  std::vector<int> order(jobs.size());
+  for (int j = 0; j < static_cast<int>(jobs.size()); j++) order[j] = j;
+  std::stable_sort(order.begin(), order.end(), [&jobs](int a, int b) {
+    return jobs[a].cost_ > jobs[b].cost_;
+  });
+
+  std::vector<std::function<void()>> tasks;
+  for (int j : order) {
+    tasks.push_back([&job = jobs[j]] {
+      K_Means k_means(job.data_, job.initialization_method_,
+                      GRID_JOB_NUM_OF_THREADS);
+      k_means.SetAlgorithm(CLUSTERING_ALGORITHM);
+      k_means.SetBatchSize(MINI_BATCH_SIZE);
+      k_means.SetPrecision(CLUSTERING_PRECISION);
+      k_means.Run();
+
+      std::ostringstream row;
+      row << job.data_->GetFileName() << ",";
+      k_means.exportResults(row);
+      job.row_ = row.str();
+    });
+  }
+
+  WorkStealingPool pool(GRID_NUM_OF_THREADS);
+  pool.Run(std::move(tasks));
+
+  for (const Job &job : jobs) {
+    std::cout << job.row_ << std::endl;
+  }
+}
+
 int main(int argc, char *argv[]) {
 #if OUT_TO_FILE && !CLUSTER_ALL_DATA
   std::string file_name =
@@ -138,42 +200,18 @@ int main(int argc, char *argv[]) {
                "Final SSE, Best # of Iterations\n";
 #endif
 
-#if CHECK_PERFORMANCE
-  auto start = std::chrono::high_resolution_clock::now();
-#endif
-
   K_Means *k_means = nullptr;
 
 #if CLUSTER_ALL_DATA
-  for (int i = 0; i < datasets.size(); i++) {
-    for (int init_method = 0;
-         init_method < static_cast<int>(InitializationMethod::COUNT);
-         init_method++) {
-      std::cout << datasets[i]->GetFileName() << ",";
-
-      k_means = new K_Means(datasets[i],
-                            static_cast<InitializationMethod>(init_method));
-      k_means->Run();
-      k_means->exportResults();
-
-      std::cout << std::endl;
-
-      delete k_means;
-    }
-  }
+  RunGrid(datasets);
 #else
   k_means = new K_Means(data);
+  k_means->SetAlgorithm(CLUSTERING_ALGORITHM);
+  k_means->SetBatchSize(MINI_BATCH_SIZE);
+  k_means->SetPrecision(CLUSTERING_PRECISION);
   k_means->Run();
 #endif
 
-#if CHECK_PERFORMANCE
-  auto stop = std::chrono::high_resolution_clock::now();
-  auto duration =
-      std::chrono::duration_cast<std::chrono::milliseconds>(stop - start);
-  std::cout << "Clustering took: " << duration.count() << " milliseconds"
-            << std::endl;
-#endif
-
 #if !VERBOSE_OUTPUT && !CLUSTER_ALL_DATA
   k_means->exportResults();
 #endif
@@ -0,0 +1,90 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+// Clusters datasets too large to load by streaming them from disk, see
+// algo/out_of_core_k_means.h. Text and convert_dataset binary files are both
+// read in blocks, a binary copy saves parsing the text on every pass.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../algo/out_of_core_k_means.h"
+#include "../data/dataset_io.h"
+#include "../util/config.h"
+
+int main(int argc, char* argv[]) {
+  NormalizationMethod normalization = NormalizationMethod::MIN_MAX;
+  int num_of_clusters = 0;
+  int num_of_threads = NUM_OF_THREADS;
+  int max_iterations = 100;
+  unsigned int seed = 1;
+  std::string labels_path;
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--normalize" && i + 1 < argc) {
+      std::string method = argv[++i];
+      if (method == "min_max") {
+        normalization = NormalizationMethod::MIN_MAX;
+      } else if (method == "z_score") {
+        normalization = NormalizationMethod::Z_SCORE;
+      } else {
+        std::cout << "Unknown normalization: " << method << std::endl;
+        return 1;
+      }
+    } else if (arg == "--k" && i + 1 < argc) {
+      num_of_clusters = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_of_threads = std::stoi(argv[++i]);
+    } else if (arg == "--max_iterations" && i + 1 < argc) {
+      max_iterations = std::stoi(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+    } else if (arg == "--labels" && i + 1 < argc) {
+      labels_path = argv[++i];
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+
+  if (inputs.size() != 1) {
+    std::cout << "Usage: " << argv[0]
+              << " [--k <clusters>] [--normalize min_max|z_score] "
+                 "[--threads <n>] [--max_iterations <n>] [--seed <n>] "
+                 "[--labels <file>] <dataset>\n"
+              << "Prints the results row of data_clustering. k defaults to "
+                 "the dataset header's, or sqrt(points / 2) when the header "
+                 "has none, --labels writes one label per line.\n";
+    return 1;
+  }
+
+  std::string path = ResolveDatasetPath(inputs[0]);
+  OutOfCoreKMeans k_means(path, num_of_clusters, max_iterations, 0.001,
+                          normalization, num_of_threads);
+  k_means.SetSeed(seed);
+  k_means.SetKeepLabels(!labels_path.empty());
+  k_means.Run();
+
+  std::cout << "Dataset,Normalization,Initialization,Best Initial SSE, Best "
+               "Final SSE, Best # of Iterations\n";
+  std::cout << inputs[0] << ",";
+  k_means.exportResults();
+  std::cout << std::endl;
+
+  if (!labels_path.empty()) {
+    std::ofstream out(labels_path);
+    if (!out.is_open()) {
+      std::cout << "File failed to open. PATH :: " << labels_path
+                << std::endl;
+      return 1;
+    }
+    for (int label : k_means.GetLabels()) out << label << "\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+// Runs several FLOAT32 K_Means on one Data at once, the way RunGrid does,
+// so the first requests for the shared float copy race each other. Every
+// concurrent run has to end on the SSE the same seed gives when run alone
+// afterwards, and the copy has to hold every point.
+
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../algo/k_means.h"
+#include "../data/data.h"
+#include "../util/config.h"
+
+#define TEST_NUM_OF_THREADS 4
+#define TEST_NUM_OF_CLUSTERS 6
+#define TEST_NUM_OF_RUNS 2
+
+static void Configure(K_Means& k_means, unsigned int seed) {
+  k_means.SetAlgorithm(Algorithm::LLOYD);
+  k_means.SetPrecision(Precision::FLOAT32);
+  k_means.SetSeed(seed);
+}
+
+int main(int argc, char* argv[]) {
+  if (argc != 2) {
+    std::cout << "usage: float_points_test <dataset>" << std::endl;
+    return 1;
+  }
+
+  Data data(argv[1], TEST_NUM_OF_CLUSTERS, 100, TEST_NUM_OF_RUNS);
+
+  std::vector<double> concurrent_sse(TEST_NUM_OF_THREADS);
+  std::latch start(TEST_NUM_OF_THREADS);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < TEST_NUM_OF_THREADS; t++) {
+    threads.emplace_back([&, t] {
+      K_Means k_means(&data, InitializationMethod::RANDOM_SELECTION, 1);
+      Configure(k_means, t + 1);
+      start.arrive_and_wait();
+      k_means.Run();
+      concurrent_sse[t] = k_means.GetLowestFinalSSE();
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  int failures = 0;
+  const Matrix& points = data.GetPoints();
+  const FloatMatrix& float_points = data.GetFloatPoints();
+  if (float_points.Rows() != points.Rows()) {
+    std::cout << "float copy has " << float_points.Rows() << " rows, expected "
+              << points.Rows() << std::endl;
+    failures++;
+  } else {
+    for (size_t i = 0; i < points.Rows(); i++) {
+      for (int j = 0; j < data.GetNumOfDimensions(); j++) {
+        if (float_points.Row(i)[j] != static_cast<float>(points[i][j])) {
+          std::cout << "float copy differs at point " << i << std::endl;
+          failures++;
+          break;
+        }
+      }
+    }
+  }
+
+  for (int t = 0; t < TEST_NUM_OF_THREADS; t++) {
+    K_Means k_means(&data, InitializationMethod::RANDOM_SELECTION, 1);
+    Configure(k_means, t + 1);
+    k_means.Run();
+    if (k_means.GetLowestFinalSSE() != concurrent_sse[t]) {
+      std::cout << "seed " << t + 1 << ": concurrent SSE "
+                << concurrent_sse[t] << ", alone "
+                << k_means.GetLowestFinalSSE() << std::endl;
+      failures++;
+    }
+  }
+
+  if (failures) return 1;
+  std::cout << "ok" << std::endl;
+  return 0;
+}
@@ -0,0 +1,32 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./allocation_counter.h"
+
+#include <atomic>
+
+namespace {
+
+std::atomic<uint64_t> total_allocations{0};
+thread_local uint64_t thread_allocations = 0;
+thread_local int uncounted_depth = 0;
+
+}  // namespace
+
+void AllocationCounter::Record() {
+  if (uncounted_depth != 0) return;
+  total_allocations.fetch_add(1, std::memory_order_relaxed);
+  thread_allocations++;
+}
+
+uint64_t AllocationCounter::Total() {
+  return total_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::ThisThread() { return thread_allocations; }
+
+UncountedAllocations::UncountedAllocations() { uncounted_depth++; }
+
+UncountedAllocations::~UncountedAllocations() { uncounted_depth--; }
@@ -0,0 +1,43 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef ALLOCATION_COUNTER_H_
+#define ALLOCATION_COUNTER_H_
+
+#include <cstdint>
+
+// Heap allocation counts, kept by the replacement of the global operator new
+// in util/count_allocations.cc. Only binaries built with COUNT_ALLOCATIONS
+// link it in, every count stays 0 in the others. Each allocation costs one
+// relaxed atomic add and one thread local add.
+//
+// K_Means records the allocations of every iteration, counting every thread
+// while a restart is split across its pool, so the steady state iteration
+// loop can be checked to stay at zero. Total() is only exact for that while
+// nothing else in the process allocates, as in clustering_bench.
+class AllocationCounter {
+ public:
+  // counts one allocation by the calling thread, called by operator new
+  static void Record();
+  // allocations by every thread since the process started, not counting
+  // uncounted scopes
+  static uint64_t Total();
+  // allocations by the calling thread, not counting uncounted scopes
+  static uint64_t ThisThread();
+};
+
+// allocations made by the calling thread while one of these is alive are
+// left out of both counts, for bookkeeping such as profile rows that should
+// not show up in the counts it is recording
+class UncountedAllocations {
+ public:
+  UncountedAllocations();
+  ~UncountedAllocations();
+
+  UncountedAllocations(const UncountedAllocations&) = delete;
+  UncountedAllocations& operator=(const UncountedAllocations&) = delete;
+};
+
+#endif  // ALLOCATION_COUNTER_H_
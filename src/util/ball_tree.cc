@@ -0,0 +1,146 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./ball_tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "./kernels.h"
+
+namespace {
+
+// balls are split at the median, so the depth stays near log2(k) and the
+// search stack never holds more than one pending ball per level plus one
+constexpr int kMaxStack = 128;
+
+}  // namespace
+
+void BallTree::Build(const Matrix& centroids, int leaf_size) {
+  size_t num_of_clusters = centroids.Rows();
+  size_t num_of_dimensions = centroids.Cols();
+
+  nodes_.clear();
+  indices_.resize(num_of_clusters);
+  std::iota(indices_.begin(), indices_.end(), 0);
+  if (num_of_clusters == 0) return;
+
+  // a binary tree over k leaves or fewer has under 2k nodes
+  if (centers_.Rows() < 2 * num_of_clusters ||
+      centers_.Cols() != num_of_dimensions) {
+    centers_.Resize(2 * num_of_clusters, num_of_dimensions);
+  }
+
+  BuildNode(centroids, 0, static_cast<int>(num_of_clusters),
+            std::max(leaf_size, 1));
+
+  if (centroids_.Rows() != num_of_clusters ||
+      centroids_.Cols() != num_of_dimensions) {
+    centroids_.Resize(num_of_clusters, num_of_dimensions);
+  }
+  for (size_t r = 0; r < num_of_clusters; r++) {
+    std::copy_n(centroids.Row(indices_[r]), num_of_dimensions,
+                centroids_.Row(r));
+  }
+}
+
+int BallTree::BuildNode(const Matrix& centroids, int begin, int end,
+                        int leaf_size) {
+  const Kernels& kernels = GetKernels();
+  size_t num_of_dimensions = centroids.Cols();
+  size_t stride = centroids.Stride();
+
+  int node = static_cast<int>(nodes_.size());
+  nodes_.push_back({begin, end, -1, -1, 0.0});
+
+  double* center = centers_.Row(node);
+  std::fill_n(center, num_of_dimensions, 0.0);
+  for (int r = begin; r < end; r++) {
+    const double* centroid = centroids.Row(indices_[r]);
+    for (size_t j = 0; j < num_of_dimensions; j++) center[j] += centroid[j];
+  }
+  for (size_t j = 0; j < num_of_dimensions; j++) center[j] /= end - begin;
+
+  double radius = 0.0;
+  for (int r = begin; r < end; r++) {
+    radius = std::max(radius, kernels.squared_distance_(
+                                  center, centroids.Row(indices_[r]), stride));
+  }
+  nodes_[node].radius_ = std::sqrt(radius);
+  if (end - begin <= leaf_size || radius == 0.0) return node;
+
+  // split at the median of the dimension the centroids spread most along
+  size_t widest = 0;
+  double width = -1.0;
+  for (size_t j = 0; j < num_of_dimensions; j++) {
+    double lowest = centroids.Row(indices_[begin])[j];
+    double highest = lowest;
+    for (int r = begin + 1; r < end; r++) {
+      lowest = std::min(lowest, centroids.Row(indices_[r])[j]);
+      highest = std::max(highest, centroids.Row(indices_[r])[j]);
+    }
+    if (highest - lowest > width) {
+      width = highest - lowest;
+      widest = j;
+    }
+  }
+
+  int middle = begin + (end - begin) / 2;
+  std::nth_element(indices_.begin() + begin, indices_.begin() + middle,
+                   indices_.begin() + end,
+                   [&centroids, widest](int a, int b) {
+                     return centroids.Row(a)[widest] <
+                            centroids.Row(b)[widest];
+                   });
+
+  int left = BuildNode(centroids, begin, middle, leaf_size);
+  int right = BuildNode(centroids, middle, end, leaf_size);
+  nodes_[node].left_ = left;
+  nodes_[node].right_ = right;
+  return node;
+}
+
+void BallTree::Within(const double* point, double radius,
+                      std::vector<int>& found,
+                      long long* num_of_distances) const {
+  const Kernels& kernels = GetKernels();
+  size_t stride = centroids_.Stride();
+  found.clear();
+  if (nodes_.empty()) return;
+
+  // compared on squares, a ball is skipped when
+  // ||x - center||^2 > (radius + ball radius)^2
+  int stack[kMaxStack];
+  int top = 0;
+  stack[top++] = 0;
+  long long distances = 0;
+
+  while (top > 0) {
+    int index = stack[--top];
+    const Node& node = nodes_[index];
+    double reach = radius + node.radius_;
+    double distance =
+        kernels.squared_distance_(point, centers_.Row(index), stride);
+    distances++;
+    if (distance > reach * reach) continue;
+
+    if (node.left_ == -1) {
+      for (int r = node.begin_; r < node.end_; r++) {
+        if (kernels.squared_distance_(point, centroids_.Row(r), stride) <=
+            radius * radius) {
+          found.push_back(indices_[r]);
+        }
+      }
+      distances += node.end_ - node.begin_;
+      continue;
+    }
+    stack[top++] = node.right_;
+    stack[top++] = node.left_;
+  }
+
+  std::sort(found.begin(), found.end());
+  *num_of_distances += distances;
+}
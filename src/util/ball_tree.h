@@ -0,0 +1,47 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef BALL_TREE_H_
+#define BALL_TREE_H_
+
+#include <vector>
+
+#include "../data/matrix.h"
+#include "./config.h"
+
+// Ball tree over a small set of centroids, rebuilt every iteration. Each node
+// is the ball around the mean of its centroids that holds them all; no
+// centroid in a ball is closer to x than ||x - center|| - radius, so a range
+// query skips every ball whose bound is beyond the range.
+class BallTree {
+ private:
+  struct Node {
+    int begin_;  // tree ordered centroids [begin_, end_) are in the ball
+    int end_;
+    int left_;  // -1 on leaves
+    int right_;
+    double radius_;
+  };
+
+  std::vector<Node> nodes_;
+  Matrix centers_;  // one row per node
+  // the centroids in tree order, indices_ maps a row back to its centroid
+  Matrix centroids_;
+  std::vector<int> indices_;
+
+  int BuildNode(const Matrix& centroids, int begin, int end, int leaf_size);
+
+ public:
+  // rebuilds the tree in place, reusing the previous allocations
+  void Build(const Matrix& centroids, int leaf_size = BALL_TREE_LEAF_SIZE);
+
+  // indices of the centroids within radius of point (stride values like the
+  // centroid rows), in increasing order. Adds the number of distances
+  // computed.
+  void Within(const double* point, double radius, std::vector<int>& found,
+              long long* num_of_distances) const;
+};
+
+#endif  // BALL_TREE_H_
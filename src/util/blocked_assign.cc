@@ -0,0 +1,456 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./blocked_assign.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "./kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BLOCKED_ASSIGN_X86 1
+#include <immintrin.h>
+#else
+#define BLOCKED_ASSIGN_X86 0
+#endif
+
+namespace {
+
+// rows of points handled by one micro-kernel call
+constexpr size_t kMicroRows = 4;
+
+// picks the winner among the per-lane minimums, on equal distances the lowest
+// centroid index wins as it would in a sequential scan
+template <typename T>
+inline void FinishRow(const T* best_distances, const T* best_indices,
+                      int* label, double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+  for (size_t j = 0; j < kCentroidPanelWidth; j++) {
+    int index = static_cast<int>(best_indices[j]);
+    if (best_distances[j] < lowest ||
+        (best_distances[j] == lowest && index < nearest)) {
+      lowest = best_distances[j];
+      nearest = index;
+    }
+  }
+  *label = nearest;
+  *distance = lowest;
+}
+
+// kRows x 8 dot products of the rows against one packed panel
+template <size_t kRows, typename T>
+inline void PanelProductsScalar(const T* points, size_t stride,
+                                const T* panel_data, size_t d,
+                                T (&acc)[kRows][kCentroidPanelWidth]) {
+  for (size_t r = 0; r < kRows; r++) {
+    std::fill(acc[r], acc[r] + kCentroidPanelWidth, T(0));
+  }
+  for (size_t p = 0; p < d; p++) {
+    const T* c = panel_data + p * kCentroidPanelWidth;
+    for (size_t r = 0; r < kRows; r++) {
+      T x = points[r * stride + p];
+      for (size_t j = 0; j < kCentroidPanelWidth; j++) {
+        acc[r][j] += x * c[j];
+      }
+    }
+  }
+}
+
+// Each lane of the kRows x 8 best distance/index block tracks the nearest
+// centroid among those that share its lane, panels are visited in increasing
+// order so a strict comparison keeps the lowest index per lane
+template <size_t kRows, typename T>
+void MicroKernelScalar(const T* points, size_t stride, const T* squared_norms,
+                       const BasicPackedCentroids<T>& packed, int* labels,
+                       double* distances) {
+  size_t d = packed.num_of_dimensions_;
+  T best_distances[kRows][kCentroidPanelWidth];
+  T best_indices[kRows][kCentroidPanelWidth] = {};
+  for (size_t r = 0; r < kRows; r++) {
+    std::fill(best_distances[r], best_distances[r] + kCentroidPanelWidth,
+              std::numeric_limits<T>::infinity());
+  }
+
+  for (size_t panel = 0; panel < packed.num_of_panels_; panel++) {
+    const T* panel_data = &packed.data_[panel * d * kCentroidPanelWidth];
+    const T* panel_norms = &packed.norms_[panel * kCentroidPanelWidth];
+
+    T acc[kRows][kCentroidPanelWidth];
+    PanelProductsScalar<kRows>(points, stride, panel_data, d, acc);
+
+    for (size_t r = 0; r < kRows; r++) {
+      for (size_t j = 0; j < kCentroidPanelWidth; j++) {
+        T dist = squared_norms[r] + panel_norms[j] - 2 * acc[r][j];
+        if (dist < best_distances[r][j]) {
+          best_distances[r][j] = dist;
+          best_indices[r][j] = static_cast<T>(panel * kCentroidPanelWidth + j);
+        }
+      }
+    }
+  }
+
+  for (size_t r = 0; r < kRows; r++) {
+    FinishRow(best_distances[r], best_indices[r], &labels[r], &distances[r]);
+  }
+}
+
+// every distance of the rows to the packed panels, written to out instead
+// of reduced to an argmin
+template <size_t kRows>
+void DistanceKernelScalar(const double* points, size_t stride,
+                          const double* squared_norms,
+                          const PackedCentroids& packed, size_t first_panel,
+                          size_t num_of_panels, double* out,
+                          size_t out_stride) {
+  size_t d = packed.num_of_dimensions_;
+  for (size_t panel = 0; panel < num_of_panels; panel++) {
+    size_t source = first_panel + panel;
+    const double* panel_data = &packed.data_[source * d * kCentroidPanelWidth];
+    const double* panel_norms = &packed.norms_[source * kCentroidPanelWidth];
+
+    double acc[kRows][kCentroidPanelWidth];
+    PanelProductsScalar<kRows>(points, stride, panel_data, d, acc);
+    for (size_t r = 0; r < kRows; r++) {
+      double* row = out + r * out_stride + panel * kCentroidPanelWidth;
+      for (size_t j = 0; j < kCentroidPanelWidth; j++) {
+        row[j] = squared_norms[r] + panel_norms[j] - 2 * acc[r][j];
+      }
+    }
+  }
+}
+
+#if BLOCKED_ASSIGN_X86
+
+// kRows x 8 dot products of the rows against one packed panel in 2 * kRows
+// ymm registers, each step over a dimension loads one packed row of 8
+// centroids and broadcasts one coordinate per point
+template <size_t kRows>
+__attribute__((target("avx2,fma"), always_inline)) inline void
+PanelProductsAvx2(const double* points, size_t stride,
+                  const double* panel_data, size_t d,
+                  __m256d (&acc)[kRows][2]) {
+  for (size_t r = 0; r < kRows; r++) {
+    acc[r][0] = _mm256_setzero_pd();
+    acc[r][1] = _mm256_setzero_pd();
+  }
+
+  for (size_t p = 0; p < d; p++) {
+    __m256d c_low = _mm256_loadu_pd(panel_data + p * kCentroidPanelWidth);
+    __m256d c_high = _mm256_loadu_pd(panel_data + p * kCentroidPanelWidth + 4);
+    for (size_t r = 0; r < kRows; r++) {
+      __m256d x = _mm256_broadcast_sd(points + r * stride + p);
+      acc[r][0] = _mm256_fmadd_pd(x, c_low, acc[r][0]);
+      acc[r][1] = _mm256_fmadd_pd(x, c_high, acc[r][1]);
+    }
+  }
+}
+
+// kRows x 8 block of dot products held in 2 * kRows ymm registers, each step
+// over a dimension loads one packed row of 8 centroids and broadcasts one
+// coordinate per point. The running minimum and its centroid index stay in
+// registers across every panel, so the argmin costs a compare and two blends
+// per panel instead of a scalar scan.
+template <size_t kRows>
+__attribute__((target("avx2,fma"))) void MicroKernelAvx2(
+    const double* points, size_t stride, const double* squared_norms,
+    const PackedCentroids& packed, int* labels, double* distances) {
+  size_t d = packed.num_of_dimensions_;
+
+  __m256d best_distances[kRows][2];
+  __m256d best_indices[kRows][2];
+  __m256d point_norms[kRows];
+  for (size_t r = 0; r < kRows; r++) {
+    best_distances[r][0] =
+        _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    best_distances[r][1] = best_distances[r][0];
+    best_indices[r][0] = _mm256_setzero_pd();
+    best_indices[r][1] = _mm256_setzero_pd();
+    point_norms[r] = _mm256_set1_pd(squared_norms[r]);
+  }
+
+  __m256d indices_low = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+  __m256d indices_high = _mm256_setr_pd(4.0, 5.0, 6.0, 7.0);
+  const __m256d panel_step =
+      _mm256_set1_pd(static_cast<double>(kCentroidPanelWidth));
+  const __m256d minus_two = _mm256_set1_pd(-2.0);
+
+  for (size_t panel = 0; panel < packed.num_of_panels_; panel++) {
+    const double* panel_data = &packed.data_[panel * d * kCentroidPanelWidth];
+    const double* panel_norms = &packed.norms_[panel * kCentroidPanelWidth];
+
+    __m256d acc[kRows][2];
+    PanelProductsAvx2<kRows>(points, stride, panel_data, d, acc);
+
+    __m256d norms_low = _mm256_loadu_pd(panel_norms);
+    __m256d norms_high = _mm256_loadu_pd(panel_norms + 4);
+    for (size_t r = 0; r < kRows; r++) {
+      __m256d dist_low = _mm256_fmadd_pd(
+          minus_two, acc[r][0], _mm256_add_pd(point_norms[r], norms_low));
+      __m256d dist_high = _mm256_fmadd_pd(
+          minus_two, acc[r][1], _mm256_add_pd(point_norms[r], norms_high));
+
+      __m256d closer_low =
+          _mm256_cmp_pd(dist_low, best_distances[r][0], _CMP_LT_OQ);
+      __m256d closer_high =
+          _mm256_cmp_pd(dist_high, best_distances[r][1], _CMP_LT_OQ);
+      best_distances[r][0] =
+          _mm256_blendv_pd(best_distances[r][0], dist_low, closer_low);
+      best_distances[r][1] =
+          _mm256_blendv_pd(best_distances[r][1], dist_high, closer_high);
+      best_indices[r][0] =
+          _mm256_blendv_pd(best_indices[r][0], indices_low, closer_low);
+      best_indices[r][1] =
+          _mm256_blendv_pd(best_indices[r][1], indices_high, closer_high);
+    }
+
+    indices_low = _mm256_add_pd(indices_low, panel_step);
+    indices_high = _mm256_add_pd(indices_high, panel_step);
+  }
+
+  alignas(32) double lane_distances[kCentroidPanelWidth];
+  alignas(32) double lane_indices[kCentroidPanelWidth];
+  for (size_t r = 0; r < kRows; r++) {
+    _mm256_store_pd(lane_distances, best_distances[r][0]);
+    _mm256_store_pd(lane_distances + 4, best_distances[r][1]);
+    _mm256_store_pd(lane_indices, best_indices[r][0]);
+    _mm256_store_pd(lane_indices + 4, best_indices[r][1]);
+    FinishRow(lane_distances, lane_indices, &labels[r], &distances[r]);
+  }
+}
+
+template <size_t kRows>
+__attribute__((target("avx2,fma"))) void DistanceKernelAvx2(
+    const double* points, size_t stride, const double* squared_norms,
+    const PackedCentroids& packed, size_t first_panel, size_t num_of_panels,
+    double* out, size_t out_stride) {
+  size_t d = packed.num_of_dimensions_;
+  const __m256d minus_two = _mm256_set1_pd(-2.0);
+  __m256d point_norms[kRows];
+  for (size_t r = 0; r < kRows; r++) {
+    point_norms[r] = _mm256_set1_pd(squared_norms[r]);
+  }
+
+  for (size_t panel = 0; panel < num_of_panels; panel++) {
+    size_t source = first_panel + panel;
+    const double* panel_data = &packed.data_[source * d * kCentroidPanelWidth];
+    const double* panel_norms = &packed.norms_[source * kCentroidPanelWidth];
+
+    __m256d acc[kRows][2];
+    PanelProductsAvx2<kRows>(points, stride, panel_data, d, acc);
+
+    __m256d norms_low = _mm256_loadu_pd(panel_norms);
+    __m256d norms_high = _mm256_loadu_pd(panel_norms + 4);
+    for (size_t r = 0; r < kRows; r++) {
+      double* row = out + r * out_stride + panel * kCentroidPanelWidth;
+      _mm256_storeu_pd(row, _mm256_fmadd_pd(minus_two, acc[r][0],
+                                            _mm256_add_pd(point_norms[r],
+                                                          norms_low)));
+      _mm256_storeu_pd(row + 4, _mm256_fmadd_pd(minus_two, acc[r][1],
+                                                _mm256_add_pd(point_norms[r],
+                                                              norms_high)));
+    }
+  }
+}
+
+// Same blocking in single precision: a panel of 8 centroids fills one ymm
+// register, so each row needs one accumulator and one best distance/index
+// register instead of two
+template <size_t kRows>
+__attribute__((target("avx2,fma"))) void MicroKernelAvx2(
+    const float* points, size_t stride, const float* squared_norms,
+    const PackedFloatCentroids& packed, int* labels, double* distances) {
+  size_t d = packed.num_of_dimensions_;
+
+  __m256 best_distances[kRows];
+  __m256 best_indices[kRows];
+  __m256 point_norms[kRows];
+  for (size_t r = 0; r < kRows; r++) {
+    best_distances[r] = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    best_indices[r] = _mm256_setzero_ps();
+    point_norms[r] = _mm256_set1_ps(squared_norms[r]);
+  }
+
+  __m256 indices = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f,
+                                  7.0f);
+  const __m256 panel_step =
+      _mm256_set1_ps(static_cast<float>(kCentroidPanelWidth));
+  const __m256 minus_two = _mm256_set1_ps(-2.0f);
+
+  for (size_t panel = 0; panel < packed.num_of_panels_; panel++) {
+    const float* panel_data = &packed.data_[panel * d * kCentroidPanelWidth];
+    const float* panel_norms = &packed.norms_[panel * kCentroidPanelWidth];
+
+    __m256 acc[kRows];
+    for (size_t r = 0; r < kRows; r++) {
+      acc[r] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < d; p++) {
+      __m256 c = _mm256_loadu_ps(panel_data + p * kCentroidPanelWidth);
+      for (size_t r = 0; r < kRows; r++) {
+        __m256 x = _mm256_broadcast_ss(points + r * stride + p);
+        acc[r] = _mm256_fmadd_ps(x, c, acc[r]);
+      }
+    }
+
+    __m256 norms = _mm256_loadu_ps(panel_norms);
+    for (size_t r = 0; r < kRows; r++) {
+      __m256 dist = _mm256_fmadd_ps(minus_two, acc[r],
+                                    _mm256_add_ps(point_norms[r], norms));
+      __m256 closer = _mm256_cmp_ps(dist, best_distances[r], _CMP_LT_OQ);
+      best_distances[r] = _mm256_blendv_ps(best_distances[r], dist, closer);
+      best_indices[r] = _mm256_blendv_ps(best_indices[r], indices, closer);
+    }
+
+    indices = _mm256_add_ps(indices, panel_step);
+  }
+
+  alignas(32) float lane_distances[kCentroidPanelWidth];
+  alignas(32) float lane_indices[kCentroidPanelWidth];
+  for (size_t r = 0; r < kRows; r++) {
+    _mm256_store_ps(lane_distances, best_distances[r]);
+    _mm256_store_ps(lane_indices, best_indices[r]);
+    FinishRow(lane_distances, lane_indices, &labels[r], &distances[r]);
+  }
+}
+
+#endif  // BLOCKED_ASSIGN_X86
+
+template <size_t kRows, typename T>
+void MicroKernel(bool use_avx2, const T* points, size_t stride,
+                 const T* squared_norms, const BasicPackedCentroids<T>& packed,
+                 int* labels, double* distances) {
+#if BLOCKED_ASSIGN_X86
+  if (use_avx2) {
+    MicroKernelAvx2<kRows>(points, stride, squared_norms, packed, labels,
+                           distances);
+    return;
+  }
+#endif
+  MicroKernelScalar<kRows>(points, stride, squared_norms, packed, labels,
+                           distances);
+}
+
+template <size_t kRows>
+void DistanceKernel(bool use_avx2, const double* points, size_t stride,
+                    const double* squared_norms, const PackedCentroids& packed,
+                    size_t first_panel, size_t num_of_panels, double* out,
+                    size_t out_stride) {
+#if BLOCKED_ASSIGN_X86
+  if (use_avx2) {
+    DistanceKernelAvx2<kRows>(points, stride, squared_norms, packed,
+                              first_panel, num_of_panels, out, out_stride);
+    return;
+  }
+#endif
+  DistanceKernelScalar<kRows>(points, stride, squared_norms, packed,
+                              first_panel, num_of_panels, out, out_stride);
+}
+
+}  // namespace
+
+template <typename T>
+void PackCentroids(const BasicMatrix<T>& centroids, const T* squared_norms,
+                   BasicPackedCentroids<T>& packed) {
+  size_t k = centroids.Rows();
+  size_t d = centroids.Cols();
+  size_t num_of_panels = (k + kCentroidPanelWidth - 1) / kCentroidPanelWidth;
+
+  packed.num_of_clusters_ = k;
+  packed.num_of_dimensions_ = d;
+  packed.num_of_panels_ = num_of_panels;
+  packed.data_.assign(num_of_panels * d * kCentroidPanelWidth, T(0));
+  packed.norms_.assign(num_of_panels * kCentroidPanelWidth,
+                       std::numeric_limits<T>::infinity());
+
+  for (size_t j = 0; j < k; j++) {
+    size_t panel = j / kCentroidPanelWidth;
+    size_t lane = j % kCentroidPanelWidth;
+    T* dest = &packed.data_[panel * d * kCentroidPanelWidth];
+    const T* centroid = centroids.Row(j);
+    for (size_t p = 0; p < d; p++) {
+      dest[p * kCentroidPanelWidth + lane] = centroid[p];
+    }
+    packed.norms_[j] = squared_norms[j];
+  }
+}
+
+template <typename T>
+void AssignBlock(const T* points, size_t stride, const T* squared_norms,
+                 size_t rows, const BasicPackedCentroids<T>& packed,
+                 int* labels, double* distances) {
+  bool use_avx2 = GetKernels<T>().isa_ >= KernelIsa::AVX2;
+
+  // each micro-kernel call sweeps every centroid panel for its rows, the
+  // packed centroids (k x d values) are reused from L1/L2 by every call
+  size_t r = 0;
+  for (; r + kMicroRows <= rows; r += kMicroRows) {
+    MicroKernel<kMicroRows>(use_avx2, points + r * stride, stride,
+                            squared_norms + r, packed, labels + r,
+                            distances + r);
+  }
+  switch (rows - r) {
+    case 3:
+      MicroKernel<3>(use_avx2, points + r * stride, stride, squared_norms + r,
+                     packed, labels + r, distances + r);
+      break;
+    case 2:
+      MicroKernel<2>(use_avx2, points + r * stride, stride, squared_norms + r,
+                     packed, labels + r, distances + r);
+      break;
+    case 1:
+      MicroKernel<1>(use_avx2, points + r * stride, stride, squared_norms + r,
+                     packed, labels + r, distances + r);
+      break;
+    default:
+      break;
+  }
+}
+
+void BlockSquaredDistances(const double* points, size_t stride,
+                           const double* squared_norms, size_t rows,
+                           const PackedCentroids& packed, size_t first_panel,
+                           size_t num_of_panels, double* out,
+                           size_t out_stride) {
+  bool use_avx2 = GetKernels().isa_ >= KernelIsa::AVX2;
+
+  size_t r = 0;
+  for (; r + kMicroRows <= rows; r += kMicroRows) {
+    DistanceKernel<kMicroRows>(use_avx2, points + r * stride, stride,
+                               squared_norms + r, packed, first_panel,
+                               num_of_panels, out + r * out_stride,
+                               out_stride);
+  }
+  switch (rows - r) {
+    case 3:
+      DistanceKernel<3>(use_avx2, points + r * stride, stride,
+                        squared_norms + r, packed, first_panel, num_of_panels,
+                        out + r * out_stride, out_stride);
+      break;
+    case 2:
+      DistanceKernel<2>(use_avx2, points + r * stride, stride,
+                        squared_norms + r, packed, first_panel, num_of_panels,
+                        out + r * out_stride, out_stride);
+      break;
+    case 1:
+      DistanceKernel<1>(use_avx2, points + r * stride, stride,
+                        squared_norms + r, packed, first_panel, num_of_panels,
+                        out + r * out_stride, out_stride);
+      break;
+    default:
+      break;
+  }
+}
+
+template void PackCentroids<double>(const Matrix&, const double*,
+                                    PackedCentroids&);
+template void PackCentroids<float>(const FloatMatrix&, const float*,
+                                   PackedFloatCentroids&);
+template void AssignBlock<double>(const double*, size_t, const double*, size_t,
+                                  const PackedCentroids&, int*, double*);
+template void AssignBlock<float>(const float*, size_t, const float*, size_t,
+                                 const PackedFloatCentroids&, int*, double*);
@@ -0,0 +1,65 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef BLOCKED_ASSIGN_H_
+#define BLOCKED_ASSIGN_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "../data/matrix.h"
+
+// Nearest centroid search written as a blocked matrix product: a panel of
+// points is multiplied against every centroid panel with a register blocked
+// micro-kernel, and the argmin is taken while the dot products are still in
+// registers. Compared to one dot product per point/centroid pair this reuses
+// each point load across a whole panel of centroids.
+
+// number of centroids in one packed panel, matches two AVX2 registers
+constexpr size_t kCentroidPanelWidth = 8;
+
+// points handed to AssignBlock at once, a block of rows that stays in L2
+constexpr size_t kAssignBlockRows = 256;
+
+// Centroids transposed into panels of kCentroidPanelWidth: panel p holds
+// dimension 0 of centroids [8p, 8p+8), then dimension 1, and so on. Missing
+// centroids in the last panel are zero with an infinite norm so they can
+// never win the argmin.
+template <typename T>
+struct BasicPackedCentroids {
+  std::vector<T> data_;
+  std::vector<T> norms_;
+  size_t num_of_clusters_ = 0;
+  size_t num_of_dimensions_ = 0;
+  size_t num_of_panels_ = 0;
+};
+
+using PackedCentroids = BasicPackedCentroids<double>;
+using PackedFloatCentroids = BasicPackedCentroids<float>;
+
+template <typename T>
+void PackCentroids(const BasicMatrix<T>& centroids, const T* squared_norms,
+                   BasicPackedCentroids<T>& packed);
+
+// labels[r] and distances[r] receive the nearest centroid of point r and its
+// squared distance for the rows points apart by stride, rows <=
+// kAssignBlockRows. Ties go to the lowest centroid index. Float blocks run
+// the products in single precision, eight centroids per register.
+template <typename T>
+void AssignBlock(const T* points, size_t stride, const T* squared_norms,
+                 size_t rows, const BasicPackedCentroids<T>& packed,
+                 int* labels, double* distances);
+
+// The same products without the argmin: out[r * out_stride + j] receives the
+// squared distance of point r to packed row first_panel * 8 + j, for the
+// num_of_panels panels from first_panel on. Rows padding the last panel come
+// out infinite. Used by the silhouette width, which needs every pair.
+void BlockSquaredDistances(const double* points, size_t stride,
+                           const double* squared_norms, size_t rows,
+                           const PackedCentroids& packed, size_t first_panel,
+                           size_t num_of_panels, double* out,
+                           size_t out_stride);
+
+#endif  // BLOCKED_ASSIGN_H_
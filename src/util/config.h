@@ -9,15 +9,112 @@
 #define CLUSTER_ALL_DATA 1
 #define OUT_TO_FILE 1
 #define VERBOSE_OUTPUT 0
-#define CHECK_PERFORMANCE 0
+// phase timings are switched on at runtime with CLUSTERING_PROFILE, see
+// util/instrumentation.h
+// replaces the global operator new to count heap allocations, see
+// util/allocation_counter.h. Off for the production binaries, CMake turns it
+// on for clustering_bench only
+#ifndef COUNT_ALLOCATIONS
+#define COUNT_ALLOCATIONS 0
+#endif
+
+// worker threads used by K_Means, 0 uses every hardware thread
+#define NUM_OF_THREADS 0
+
+// with CLUSTER_ALL_DATA every dataset / normalization / initialization job
+// runs on one of GRID_NUM_OF_THREADS workers (0 uses every hardware thread),
+// each job clustering with GRID_JOB_NUM_OF_THREADS threads of its own
+#define GRID_NUM_OF_THREADS 0
+#define GRID_JOB_NUM_OF_THREADS 1
+
+// from this many clusters up, assignment uses the blocked matrix product
+// engine instead of scoring one point at a time
+#define BLOCKED_ASSIGN_MIN_K 8
+
+// Rows of the point and centroid matrices start on this boundary and are
+// zero padded to a multiple of it (64 bytes = one cache line / AVX-512
+// register)
+#define ROW_ALIGNMENT_BYTES 64
 
 enum class InitializationMethod {
   RANDOM_SELECTION = 0,
   RANDOM_PARTITION = 1,
   MAX_I_MIN = 2,
+  KMEANS_PLUS_PLUS = 3,
+  KMEANS_PARALLEL = 4,
+  COUNT
+};
+
+// k-means|| oversamples this many times k candidates per round
+#define KMEANS_PARALLEL_OVERSAMPLING 2.0
+#define KMEANS_PARALLEL_ROUNDS 5
+// weighted Lloyd iterations used to reduce the candidates down to k
+#define KMEANS_PARALLEL_RECLUSTER_ITERATIONS 20
+
+// Lloyd scores every point against every centroid each iteration, Hamerly,
+// Elkan and Yinyang reach the same assignments while skipping most of those
+// distances. Yinyang keeps one bound per group of about 10 centroids, so its
+// memory stays bounded as k grows, the validation sweep uses it below
+// BALL_TREE_MIN_K wherever filtering does not apply. Mini-batch
+// updates the centroids from small random samples and only approximates the
+// Lloyd result. Filtering walks a KD-tree over the points and hands whole
+// cells to a centroid once every other centroid is ruled out for the cell,
+// which pays off for low dimensional data. Ball tree scores the points of each
+// cluster only against the centroids near it, for large k.
+enum class Algorithm {
+  LLOYD = 0,
+  HAMERLY = 1,
+  ELKAN = 2,
+  YINYANG = 3,
+  MINI_BATCH = 4,
+  FILTERING = 5,
+  BALL_TREE = 6,
   COUNT
 };
 
+// algorithm data_clustering and run_external_validation cluster with, the
+// validation sweep picks one per k instead (see validation/validate.h)
+#define CLUSTERING_ALGORITHM Algorithm::LLOYD
+
+// cells of at most this many points are not split further
+#define KD_TREE_LEAF_SIZE 16
+// the validation sweep uses filtering for data with at most this many
+// dimensions and at least this many points, below that the tree walk costs
+// more than the distances it saves
+#define FILTERING_MAX_DIMENSIONS 8
+#define FILTERING_MIN_POINTS 10000
+
+// BALL_TREE narrows each cluster's points to the centroids a ball tree over
+// the centroids finds near it once k reaches BALL_TREE_MIN_K, below that it
+// assigns like LLOYD
+#define BALL_TREE_MIN_K 64
+// balls of at most this many centroids are scanned instead of split
+#define BALL_TREE_LEAF_SIZE 8
+
+// points sampled per mini-batch iteration by data_clustering and
+// run_external_validation, clustering_bench takes --batch-size
+#define MINI_BATCH_SIZE 1024
+// mini-batch stops once the smoothed mean squared centroid movement per
+// iteration drops below this
+#define MINI_BATCH_TOLERANCE 1e-7
+
+// OutOfCoreKMeans streams the dataset in blocks of this many points, two
+// blocks are in memory at a time, the one being assigned and the one being
+// read ahead
+#define OUT_OF_CORE_CHUNK_ROWS 65536
+
+// Scalar type of the point and centroid copies the Lloyd assignment reads.
+// FLOAT32 halves the bytes per point the assignment streams and doubles the
+// SIMD lanes, centroid sums and the SSE are still accumulated in double. The
+// float points are an extra copy next to the double ones, not a replacement,
+// so the dataset takes 1.5 times the memory. The triangle inequality
+// algorithms keep double, float rounding would loosen their bounds, which is
+// why run_validation sweeps with LLOYD under FLOAT32.
+enum class Precision { FLOAT64 = 0, FLOAT32 = 1, COUNT };
+// precision data_clustering, run_validation and run_external_validation
+// cluster with
+#define CLUSTERING_PRECISION Precision::FLOAT64
+
 enum class NormalizationMethod { MIN_MAX = 0, Z_SCORE = 1, COUNT };
 
 enum class ValidationMethod {
@@ -29,4 +126,11 @@ enum class ValidationMethod {
 #define K_MIN 2
 // K_MAX is Sqrt(Number of points / 2)
 
+// the validation sweep warm starts k from the k - 1 clustering, runs of
+// VALIDATION_CHAIN_LENGTH consecutive k are warm started one after the other
+// and separate runs go to separate threads. Warm started k keep every
+// restart, each draws its own point to split the worst cluster with
+#define VALIDATION_WARM_START 1
+#define VALIDATION_CHAIN_LENGTH 4
+
 #endif  // CONFIG_H_
@@ -0,0 +1,116 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+// Replacement of the global operator new / delete that feeds
+// AllocationCounter. Not part of clustering_lib: it is linked into the
+// binaries built with COUNT_ALLOCATIONS (see src/CMakeLists.txt), so the
+// others keep the standard allocator.
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "./allocation_counter.h"
+#include "./config.h"
+
+#if COUNT_ALLOCATIONS
+
+namespace {
+
+// as the standard operator new does, a failed allocation calls the installed
+// new_handler (which may free memory, throw or abort) and tries again, and
+// only throws bad_alloc once no handler is installed
+void* Allocate(size_t bytes) {
+  AllocationCounter::Record();
+  if (bytes == 0) bytes = 1;
+  while (true) {
+    void* memory = std::malloc(bytes);
+    if (memory != nullptr) return memory;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void* AllocateAligned(size_t bytes, std::align_val_t alignment) {
+  AllocationCounter::Record();
+  // aligned_alloc wants a size that is a multiple of the alignment
+  size_t align = static_cast<size_t>(alignment);
+  size_t rounded = (std::max<size_t>(bytes, 1) + align - 1) / align * align;
+  while (true) {
+    void* memory = std::aligned_alloc(align, rounded);
+    if (memory != nullptr) return memory;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+}
+
+}  // namespace
+
+// every allocating form is replaced, so every delete form frees with free()
+void* operator new(size_t bytes) { return Allocate(bytes); }
+void* operator new[](size_t bytes) { return Allocate(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+  try {
+    return Allocate(bytes);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+  return operator new(bytes, std::nothrow);
+}
+void* operator new(size_t bytes, std::align_val_t alignment) {
+  return AllocateAligned(bytes, alignment);
+}
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+  return AllocateAligned(bytes, alignment);
+}
+void* operator new(size_t bytes, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  try {
+    return AllocateAligned(bytes, alignment);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+void* operator new[](size_t bytes, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+  return operator new(bytes, alignment, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+void operator delete(void* memory, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+void operator delete[](void* memory, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+  std::free(memory);
+}
+
+#endif  // COUNT_ALLOCATIONS
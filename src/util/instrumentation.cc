@@ -0,0 +1,229 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./instrumentation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include "./allocation_counter.h"
+
+namespace {
+
+struct Sink {
+  std::mutex mutex_;
+  std::ofstream out_;
+  bool json_ = false;
+  std::atomic<bool> open_{false};
+  std::once_flag environment_checked_;
+};
+
+Sink& GetSink() {
+  static Sink sink;
+  return sink;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+// dataset names come from file names, only quotes and backslashes need
+// escaping
+std::string Escape(const std::string& text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+}  // namespace
+
+void Histogram::Add(uint64_t value) { buckets_[std::bit_width(value)]++; }
+
+void RunProfile::Begin(const std::string& dataset, int num_of_clusters,
+                       int run) {
+  enabled_ = Instrumentation::Enabled();
+  if (!enabled_) return;
+  UncountedAllocations uncounted;
+
+  dataset_ = dataset;
+  num_of_clusters_ = num_of_clusters;
+  run_ = run;
+  last_iteration_ = 0;
+  rows_.clear();
+  for (Histogram& histogram : phase_ns_) histogram.Clear();
+  totals_.fill(0);
+  points_moved_.Clear();
+}
+
+void RunProfile::RecordTime(Phase phase, int iteration, int64_t ns) {
+  if (!enabled_) return;
+  UncountedAllocations uncounted;
+  last_iteration_ = std::max(last_iteration_, iteration);
+  rows_.push_back({iteration,
+                   std::string(Instrumentation::PhaseName(phase)) + "_ns",
+                   ns});
+  phase_ns_[static_cast<size_t>(phase)].Add(static_cast<uint64_t>(ns));
+}
+
+void RunProfile::RecordCounter(Counter counter, int iteration,
+                               int64_t value) {
+  if (!enabled_) return;
+  UncountedAllocations uncounted;
+  last_iteration_ = std::max(last_iteration_, iteration);
+  rows_.push_back({iteration, Instrumentation::CounterName(counter), value});
+  totals_[static_cast<size_t>(counter)] += static_cast<uint64_t>(value);
+  if (counter == Counter::POINTS_MOVED) {
+    points_moved_.Add(static_cast<uint64_t>(value));
+  }
+}
+
+void RunProfile::End() {
+  if (!enabled_) return;
+  UncountedAllocations uncounted;
+
+  totals_[static_cast<size_t>(Counter::ITERATIONS)] = last_iteration_;
+  for (int c = 0; c < static_cast<int>(Counter::COUNT); c++) {
+    rows_.push_back({-1, Instrumentation::CounterName(static_cast<Counter>(c)),
+                     static_cast<int64_t>(totals_[c])});
+  }
+
+  // histograms as one row per non empty bucket, named by its upper bound
+  auto add_histogram = [this](const std::string& name,
+                              const Histogram& histogram) {
+    const auto& buckets = histogram.Buckets();
+    for (size_t b = 0; b < buckets.size(); b++) {
+      if (buckets[b] == 0) continue;
+      rows_.push_back({-1, name + "_lt_2^" + std::to_string(b),
+                       static_cast<int64_t>(buckets[b])});
+    }
+  };
+  for (int p = 0; p < static_cast<int>(Phase::COUNT); p++) {
+    add_histogram(std::string("hist_") +
+                      Instrumentation::PhaseName(static_cast<Phase>(p)) +
+                      "_ns",
+                  phase_ns_[p]);
+  }
+  add_histogram("hist_points_moved", points_moved_);
+
+  Instrumentation::Write(*this);
+}
+
+ScopedTimer::ScopedTimer(RunProfile& profile, Phase phase, int iteration)
+    : profile_(profile.Enabled() ? &profile : nullptr),
+      phase_(phase),
+      iteration_(iteration) {
+  if (profile_ != nullptr) start_ = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (profile_ == nullptr) return;
+  auto elapsed = std::chrono::steady_clock::now() - start_;
+  profile_->RecordTime(
+      phase_, iteration_,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+bool Instrumentation::Open(const std::string& path) {
+  Sink& sink = GetSink();
+  std::lock_guard<std::mutex> lock(sink.mutex_);
+
+  if (sink.out_.is_open()) sink.out_.close();
+  sink.out_.open(path);
+  if (!sink.out_.is_open()) {
+    std::cerr << "ERROR :: Could not open profile output " << path
+              << std::endl;
+    sink.open_ = false;
+    return false;
+  }
+
+  sink.json_ = EndsWith(path, ".json");
+  if (!sink.json_) sink.out_ << "dataset,k,run,iteration,metric,value\n";
+  sink.open_ = true;
+  return true;
+}
+
+void Instrumentation::Close() {
+  Sink& sink = GetSink();
+  std::lock_guard<std::mutex> lock(sink.mutex_);
+  sink.open_ = false;
+  if (sink.out_.is_open()) sink.out_.close();
+}
+
+bool Instrumentation::Enabled() {
+  Sink& sink = GetSink();
+  std::call_once(sink.environment_checked_, [] {
+    const char* path = std::getenv("CLUSTERING_PROFILE");
+    if (path != nullptr && *path != '\0') Open(path);
+  });
+  return sink.open_;
+}
+
+void Instrumentation::Write(const RunProfile& profile) {
+  Sink& sink = GetSink();
+  std::lock_guard<std::mutex> lock(sink.mutex_);
+  if (!sink.open_) return;
+
+  std::string dataset = Escape(profile.dataset_);
+  for (const RunProfile::Row& row : profile.rows_) {
+    if (sink.json_) {
+      sink.out_ << "{\"dataset\": \"" << dataset
+                << "\", \"k\": " << profile.num_of_clusters_
+                << ", \"run\": " << profile.run_
+                << ", \"iteration\": " << row.iteration_ << ", \"metric\": \""
+                << row.metric_ << "\", \"value\": " << row.value_ << "}\n";
+    } else {
+      sink.out_ << dataset << "," << profile.num_of_clusters_ << ","
+                << profile.run_ << "," << row.iteration_ << ","
+                << row.metric_ << "," << row.value_ << "\n";
+    }
+  }
+  sink.out_.flush();
+}
+
+const char* Instrumentation::PhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::INITIALIZATION:
+      return "initialization";
+    case Phase::ASSIGNMENT:
+      return "assignment";
+    case Phase::SINGLETON_REPAIR:
+      return "singleton_repair";
+    case Phase::CENTROID_UPDATE:
+      return "centroid_update";
+    case Phase::MINI_BATCH:
+      return "mini_batch";
+    case Phase::RUN:
+      return "run";
+    default:
+      return "unknown";
+  }
+}
+
+const char* Instrumentation::CounterName(Counter counter) {
+  switch (counter) {
+    case Counter::DISTANCE_EVALUATIONS:
+      return "distance_evaluations";
+    case Counter::POINTS_MOVED:
+      return "points_moved";
+    case Counter::EMPTY_CLUSTER_REPAIRS:
+      return "empty_cluster_repairs";
+    case Counter::ITERATIONS:
+      return "iterations";
+    case Counter::ALLOCATIONS:
+      return "allocations";
+    default:
+      return "unknown";
+  }
+}
@@ -0,0 +1,123 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Phase timings and counters for K_Means restarts, switched on at runtime.
+//
+// Setting the environment variable CLUSTERING_PROFILE to a file path (or
+// calling Instrumentation::Open) sends one row per dataset / restart /
+// iteration / metric to that file, CSV unless the path ends in .json, in
+// which case every row is a JSON object on its own line. Results on cout are
+// unaffected. While no sink is open a RunProfile records nothing and a
+// ScopedTimer never reads the clock, so the cost is one branch per phase.
+//
+// Each restart fills its own RunProfile without locking, the finished
+// profile is written to the sink in one go. The profile's own allocations
+// are left out of the ALLOCATIONS counter.
+
+enum class Phase {
+  INITIALIZATION = 0,
+  ASSIGNMENT = 1,
+  SINGLETON_REPAIR = 2,
+  CENTROID_UPDATE = 3,
+  MINI_BATCH = 4,
+  RUN = 5,  // a whole restart
+  COUNT
+};
+
+enum class Counter {
+  DISTANCE_EVALUATIONS = 0,
+  POINTS_MOVED = 1,
+  EMPTY_CLUSTER_REPAIRS = 2,
+  ITERATIONS = 3,  // not recorded, the highest iteration seen by the profile
+  ALLOCATIONS = 4,  // heap allocations, see util/allocation_counter.h
+  COUNT
+};
+
+// counts of values in power of two buckets, bucket b holds [2^(b-1), 2^b)
+// and bucket 0 holds 0
+class Histogram {
+ private:
+  std::array<uint64_t, 65> buckets_{};
+
+ public:
+  void Add(uint64_t value);
+  void Clear() { buckets_.fill(0); }
+  const std::array<uint64_t, 65>& Buckets() const { return buckets_; }
+};
+
+class RunProfile {
+ private:
+  struct Row {
+    int iteration_;  // 0 is initialization, -1 summarizes the restart
+    std::string metric_;
+    int64_t value_;
+  };
+
+  bool enabled_ = false;
+  std::string dataset_;
+  int num_of_clusters_ = 0;
+  int run_ = 0;
+  int last_iteration_ = 0;
+  std::vector<Row> rows_;
+  std::array<Histogram, static_cast<size_t>(Phase::COUNT)> phase_ns_;
+  std::array<uint64_t, static_cast<size_t>(Counter::COUNT)> totals_{};
+  Histogram points_moved_;
+
+  friend class Instrumentation;
+
+ public:
+  // starts a restart's profile, records nothing unless a sink is open
+  void Begin(const std::string& dataset, int num_of_clusters, int run);
+  bool Enabled() const { return enabled_; }
+
+  void RecordTime(Phase phase, int iteration, int64_t ns);
+  void RecordCounter(Counter counter, int iteration, int64_t value);
+
+  // adds the restart's totals and histograms and hands it to the sink
+  void End();
+};
+
+// times the enclosing scope into profile, nothing happens when profile is
+// not enabled
+class ScopedTimer {
+ private:
+  RunProfile* profile_;
+  Phase phase_;
+  int iteration_;
+  std::chrono::steady_clock::time_point start_;
+
+ public:
+  ScopedTimer(RunProfile& profile, Phase phase, int iteration);
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+class Instrumentation {
+ public:
+  // opens path as the sink, replacing any sink already open, returns false
+  // when the file cannot be written
+  static bool Open(const std::string& path);
+  static void Close();
+  // true once a sink is open, the first call opens CLUSTERING_PROFILE
+  static bool Enabled();
+
+  static void Write(const RunProfile& profile);
+
+  static const char* PhaseName(Phase phase);
+  static const char* CounterName(Counter counter);
+};
+
+#endif  // INSTRUMENTATION_H_
@@ -0,0 +1,697 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./kernels.h"
+
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#else
+#define KERNELS_X86 0
+#endif
+
+namespace {
+
+// Scalar versions use four independent accumulators so the compiler can keep
+// several additions in flight even without vectorizing
+
+template <typename T>
+double SquaredDistanceScalar(const T* a, const T* b, size_t n) {
+  T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    T d0 = a[i] - b[i];
+    T d1 = a[i + 1] - b[i + 1];
+    T d2 = a[i + 2] - b[i + 2];
+    T d3 = a[i + 3] - b[i + 3];
+    s0 += d0 * d0;
+    s1 += d1 * d1;
+    s2 += d2 * d2;
+    s3 += d3 * d3;
+  }
+  for (; i < n; i++) {
+    T d = a[i] - b[i];
+    s0 += d * d;
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+template <typename T>
+double DotProductScalar(const T* a, const T* b, size_t n) {
+  T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    s0 += a[i] * b[i];
+    s1 += a[i + 1] * b[i + 1];
+    s2 += a[i + 2] * b[i + 2];
+    s3 += a[i + 3] * b[i + 3];
+  }
+  for (; i < n; i++) {
+    s0 += a[i] * b[i];
+  }
+  return (s0 + s1) + (s2 + s3);
+}
+
+// one dot product per centroid, used where there is no wider kernel that
+// shares the point loads between centroids
+template <typename T, double (*DotProduct)(const T*, const T*, size_t)>
+int NearestCentroidLoop(const T* point, T point_norm, const T* centroids,
+                        const T* centroid_norms, size_t k, size_t stride,
+                        size_t n, double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+  for (size_t j = 0; j < k; j++) {
+    double dist = static_cast<double>(point_norm) + centroid_norms[j] -
+                  2 * DotProduct(point, centroids + j * stride, n);
+    if (dist < lowest) {
+      lowest = dist;
+      nearest = static_cast<int>(j);
+    }
+  }
+  *distance = lowest;
+  return nearest;
+}
+
+#if KERNELS_X86
+
+// SSE2 is part of the x86-64 baseline so it needs no target attribute
+
+double HorizontalSum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double SquaredDistanceSse2(const double* a, const double* b, size_t n) {
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128d d0 = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+    __m128d d1 = _mm_sub_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2));
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(d0, d0));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(d1, d1));
+  }
+  double sum = HorizontalSum(_mm_add_pd(acc0, acc1));
+  for (; i < n; i++) {
+    double d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+double DotProductSse2(const double* a, const double* b, size_t n) {
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0,
+                      _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    acc1 = _mm_add_pd(
+        acc1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+  }
+  double sum = HorizontalSum(_mm_add_pd(acc0, acc1));
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+double HorizontalSum(__m128 v) {
+  __m128 sums = _mm_add_ps(v, _mm_movehl_ps(v, v));
+  sums = _mm_add_ss(sums, _mm_shuffle_ps(sums, sums, 0x55));
+  return _mm_cvtss_f32(sums);
+}
+
+double SquaredDistanceSse2(const float* a, const float* b, size_t n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128 d0 = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+    __m128 d1 = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+    acc0 = _mm_add_ps(acc0, _mm_mul_ps(d0, d0));
+    acc1 = _mm_add_ps(acc1, _mm_mul_ps(d1, d1));
+  }
+  double sum = HorizontalSum(_mm_add_ps(acc0, acc1));
+  for (; i < n; i++) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+double DotProductSse2(const float* a, const float* b, size_t n) {
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 =
+        _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    acc1 = _mm_add_ps(
+        acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+  }
+  double sum = HorizontalSum(_mm_add_ps(acc0, acc1));
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+
+TARGET_AVX2 double HorizontalSum(__m256d v) {
+  __m128d low = _mm256_castpd256_pd128(v);
+  __m128d high = _mm256_extractf128_pd(v, 1);
+  low = _mm_add_pd(low, high);
+  return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+
+TARGET_AVX2 double SquaredDistanceAvx2(const double* a, const double* b,
+                                       size_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+    __m256d d1 =
+        _mm256_sub_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4));
+    acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+    acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+  }
+  for (; i + 4 <= n; i += 4) {
+    __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+    acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+  }
+  double sum = HorizontalSum(_mm256_add_pd(acc0, acc1));
+  for (; i < n; i++) {
+    double d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+TARGET_AVX2 double DotProductAvx2(const double* a, const double* b, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i),
+                           acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4),
+                           _mm256_loadu_pd(b + i + 4), acc1);
+  }
+  for (; i + 4 <= n; i += 4) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i),
+                           acc0);
+  }
+  double sum = HorizontalSum(_mm256_add_pd(acc0, acc1));
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// four centroids per pass so each load of the point feeds four FMAs
+TARGET_AVX2 int NearestCentroidAvx2(const double* point, double point_norm,
+                                    const double* centroids,
+                                    const double* centroid_norms, size_t k,
+                                    size_t stride, size_t n,
+                                    double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+
+  size_t j = 0;
+  for (; j + 4 <= k; j += 4) {
+    const double* c0 = centroids + j * stride;
+    const double* c1 = c0 + stride;
+    const double* c2 = c1 + stride;
+    const double* c3 = c2 + stride;
+
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+      __m256d x = _mm256_loadu_pd(point + i);
+      acc0 = _mm256_fmadd_pd(x, _mm256_loadu_pd(c0 + i), acc0);
+      acc1 = _mm256_fmadd_pd(x, _mm256_loadu_pd(c1 + i), acc1);
+      acc2 = _mm256_fmadd_pd(x, _mm256_loadu_pd(c2 + i), acc2);
+      acc3 = _mm256_fmadd_pd(x, _mm256_loadu_pd(c3 + i), acc3);
+    }
+    double dots[4] = {HorizontalSum(acc0), HorizontalSum(acc1),
+                      HorizontalSum(acc2), HorizontalSum(acc3)};
+    for (; i < n; i++) {
+      dots[0] += point[i] * c0[i];
+      dots[1] += point[i] * c1[i];
+      dots[2] += point[i] * c2[i];
+      dots[3] += point[i] * c3[i];
+    }
+
+    for (size_t q = 0; q < 4; q++) {
+      double dist = point_norm + centroid_norms[j + q] - 2 * dots[q];
+      if (dist < lowest) {
+        lowest = dist;
+        nearest = static_cast<int>(j + q);
+      }
+    }
+  }
+
+  for (; j < k; j++) {
+    double dist = point_norm + centroid_norms[j] -
+                  2 * DotProductAvx2(point, centroids + j * stride, n);
+    if (dist < lowest) {
+      lowest = dist;
+      nearest = static_cast<int>(j);
+    }
+  }
+
+  *distance = lowest;
+  return nearest;
+}
+
+// float versions take eight lanes per register, twice the doubles per load
+
+TARGET_AVX2 double HorizontalSum(__m256 v) {
+  return HorizontalSum(
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+TARGET_AVX2 double SquaredDistanceAvx2(const float* a, const float* b,
+                                       size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    __m256 d1 =
+        _mm256_sub_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm256_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+    acc0 = _mm256_fmadd_ps(d0, d0, acc0);
+  }
+  double sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+  for (; i < n; i++) {
+    float d = a[i] - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+TARGET_AVX2 double DotProductAvx2(const float* a, const float* b, size_t n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8),
+                           _mm256_loadu_ps(b + i + 8), acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i),
+                           acc0);
+  }
+  double sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+TARGET_AVX2 int NearestCentroidAvx2(const float* point, float point_norm,
+                                    const float* centroids,
+                                    const float* centroid_norms, size_t k,
+                                    size_t stride, size_t n,
+                                    double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+
+  size_t j = 0;
+  for (; j + 4 <= k; j += 4) {
+    const float* c0 = centroids + j * stride;
+    const float* c1 = c0 + stride;
+    const float* c2 = c1 + stride;
+    const float* c3 = c2 + stride;
+
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m256 x = _mm256_loadu_ps(point + i);
+      acc0 = _mm256_fmadd_ps(x, _mm256_loadu_ps(c0 + i), acc0);
+      acc1 = _mm256_fmadd_ps(x, _mm256_loadu_ps(c1 + i), acc1);
+      acc2 = _mm256_fmadd_ps(x, _mm256_loadu_ps(c2 + i), acc2);
+      acc3 = _mm256_fmadd_ps(x, _mm256_loadu_ps(c3 + i), acc3);
+    }
+    double dots[4] = {HorizontalSum(acc0), HorizontalSum(acc1),
+                      HorizontalSum(acc2), HorizontalSum(acc3)};
+    for (; i < n; i++) {
+      dots[0] += point[i] * c0[i];
+      dots[1] += point[i] * c1[i];
+      dots[2] += point[i] * c2[i];
+      dots[3] += point[i] * c3[i];
+    }
+
+    for (size_t q = 0; q < 4; q++) {
+      double dist = static_cast<double>(point_norm) + centroid_norms[j + q] -
+                    2 * dots[q];
+      if (dist < lowest) {
+        lowest = dist;
+        nearest = static_cast<int>(j + q);
+      }
+    }
+  }
+
+  for (; j < k; j++) {
+    double dist = static_cast<double>(point_norm) + centroid_norms[j] -
+                  2 * DotProductAvx2(point, centroids + j * stride, n);
+    if (dist < lowest) {
+      lowest = dist;
+      nearest = static_cast<int>(j);
+    }
+  }
+
+  *distance = lowest;
+  return nearest;
+}
+
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+// spills instead of using _mm512_reduce_add_pd, whose use of an undefined
+// register trips -Wmaybe-uninitialized on GCC 12
+TARGET_AVX512 double HorizontalSum(__m512d v) {
+  alignas(64) double lanes[8];
+  _mm512_store_pd(lanes, v);
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+         ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+TARGET_AVX512 double SquaredDistanceAvx512(const double* a, const double* b,
+                                           size_t n) {
+  __m512d acc0 = _mm512_setzero_pd();
+  __m512d acc1 = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+    __m512d d1 =
+        _mm512_sub_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8));
+    acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+    acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m512d d0 = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+    acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+  }
+  if (i < n) {
+    __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+    __m512d d0 = _mm512_sub_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                               _mm512_maskz_loadu_pd(mask, b + i));
+    acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+  }
+  return HorizontalSum(_mm512_add_pd(acc0, acc1));
+}
+
+TARGET_AVX512 double DotProductAvx512(const double* a, const double* b,
+                                      size_t n) {
+  __m512d acc0 = _mm512_setzero_pd();
+  __m512d acc1 = _mm512_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i),
+                           acc0);
+    acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8),
+                           _mm512_loadu_pd(b + i + 8), acc1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i),
+                           acc0);
+  }
+  if (i < n) {
+    __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+    acc0 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i),
+                           _mm512_maskz_loadu_pd(mask, b + i), acc0);
+  }
+  return HorizontalSum(_mm512_add_pd(acc0, acc1));
+}
+
+TARGET_AVX512 int NearestCentroidAvx512(const double* point,
+                                        double point_norm,
+                                        const double* centroids,
+                                        const double* centroid_norms, size_t k,
+                                        size_t stride, size_t n,
+                                        double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+
+  size_t j = 0;
+  for (; j + 4 <= k; j += 4) {
+    const double* c0 = centroids + j * stride;
+    const double* c1 = c0 + stride;
+    const double* c2 = c1 + stride;
+    const double* c3 = c2 + stride;
+
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd();
+    __m512d acc3 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+      __m512d x = _mm512_loadu_pd(point + i);
+      acc0 = _mm512_fmadd_pd(x, _mm512_loadu_pd(c0 + i), acc0);
+      acc1 = _mm512_fmadd_pd(x, _mm512_loadu_pd(c1 + i), acc1);
+      acc2 = _mm512_fmadd_pd(x, _mm512_loadu_pd(c2 + i), acc2);
+      acc3 = _mm512_fmadd_pd(x, _mm512_loadu_pd(c3 + i), acc3);
+    }
+    if (i < n) {
+      __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+      __m512d x = _mm512_maskz_loadu_pd(mask, point + i);
+      acc0 = _mm512_fmadd_pd(x, _mm512_maskz_loadu_pd(mask, c0 + i), acc0);
+      acc1 = _mm512_fmadd_pd(x, _mm512_maskz_loadu_pd(mask, c1 + i), acc1);
+      acc2 = _mm512_fmadd_pd(x, _mm512_maskz_loadu_pd(mask, c2 + i), acc2);
+      acc3 = _mm512_fmadd_pd(x, _mm512_maskz_loadu_pd(mask, c3 + i), acc3);
+    }
+    double dots[4] = {HorizontalSum(acc0), HorizontalSum(acc1),
+                      HorizontalSum(acc2), HorizontalSum(acc3)};
+
+    for (size_t q = 0; q < 4; q++) {
+      double dist = point_norm + centroid_norms[j + q] - 2 * dots[q];
+      if (dist < lowest) {
+        lowest = dist;
+        nearest = static_cast<int>(j + q);
+      }
+    }
+  }
+
+  for (; j < k; j++) {
+    double dist = point_norm + centroid_norms[j] -
+                  2 * DotProductAvx512(point, centroids + j * stride, n);
+    if (dist < lowest) {
+      lowest = dist;
+      nearest = static_cast<int>(j);
+    }
+  }
+
+  *distance = lowest;
+  return nearest;
+}
+
+// reduces in registers, spilling sixteen floats like the double version
+// does is several times slower. The halves are split through a union since
+// the extract intrinsics trip the same GCC 12 warning.
+TARGET_AVX512 double HorizontalSum(__m512 v) {
+  union {
+    __m512 whole;
+    __m256 halves[2];
+  } lanes = {v};
+  __m256 sum8 = _mm256_add_ps(lanes.halves[0], lanes.halves[1]);
+  __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(sum8),
+                           _mm256_extractf128_ps(sum8, 1));
+  __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+  return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 0x55)));
+}
+
+TARGET_AVX512 double SquaredDistanceAvx512(const float* a, const float* b,
+                                           size_t n) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    __m512 d1 = _mm512_sub_ps(_mm512_loadu_ps(a + i + 16),
+                              _mm512_loadu_ps(b + i + 16));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+    acc1 = _mm512_fmadd_ps(d1, d1, acc1);
+  }
+  for (; i + 16 <= n; i += 16) {
+    __m512 d0 = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  if (i < n) {
+    __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+    __m512 d0 = _mm512_sub_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                              _mm512_maskz_loadu_ps(mask, b + i));
+    acc0 = _mm512_fmadd_ps(d0, d0, acc0);
+  }
+  return HorizontalSum(_mm512_add_ps(acc0, acc1));
+}
+
+TARGET_AVX512 double DotProductAvx512(const float* a, const float* b,
+                                      size_t n) {
+  __m512 acc0 = _mm512_setzero_ps();
+  __m512 acc1 = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+    acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16),
+                           _mm512_loadu_ps(b + i + 16), acc1);
+  }
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i),
+                           acc0);
+  }
+  if (i < n) {
+    __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+    acc0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i),
+                           _mm512_maskz_loadu_ps(mask, b + i), acc0);
+  }
+  return HorizontalSum(_mm512_add_ps(acc0, acc1));
+}
+
+TARGET_AVX512 int NearestCentroidAvx512(const float* point, float point_norm,
+                                        const float* centroids,
+                                        const float* centroid_norms, size_t k,
+                                        size_t stride, size_t n,
+                                        double* distance) {
+  double lowest = std::numeric_limits<double>::max();
+  int nearest = 0;
+
+  size_t j = 0;
+  for (; j + 4 <= k; j += 4) {
+    const float* c0 = centroids + j * stride;
+    const float* c1 = c0 + stride;
+    const float* c2 = c1 + stride;
+    const float* c3 = c2 + stride;
+
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps();
+    __m512 acc3 = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+      __m512 x = _mm512_loadu_ps(point + i);
+      acc0 = _mm512_fmadd_ps(x, _mm512_loadu_ps(c0 + i), acc0);
+      acc1 = _mm512_fmadd_ps(x, _mm512_loadu_ps(c1 + i), acc1);
+      acc2 = _mm512_fmadd_ps(x, _mm512_loadu_ps(c2 + i), acc2);
+      acc3 = _mm512_fmadd_ps(x, _mm512_loadu_ps(c3 + i), acc3);
+    }
+    if (i < n) {
+      __mmask16 mask = static_cast<__mmask16>((1u << (n - i)) - 1);
+      __m512 x = _mm512_maskz_loadu_ps(mask, point + i);
+      acc0 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, c0 + i), acc0);
+      acc1 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, c1 + i), acc1);
+      acc2 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, c2 + i), acc2);
+      acc3 = _mm512_fmadd_ps(x, _mm512_maskz_loadu_ps(mask, c3 + i), acc3);
+    }
+    double dots[4] = {HorizontalSum(acc0), HorizontalSum(acc1),
+                      HorizontalSum(acc2), HorizontalSum(acc3)};
+
+    for (size_t q = 0; q < 4; q++) {
+      double dist = static_cast<double>(point_norm) + centroid_norms[j + q] -
+                    2 * dots[q];
+      if (dist < lowest) {
+        lowest = dist;
+        nearest = static_cast<int>(j + q);
+      }
+    }
+  }
+
+  for (; j < k; j++) {
+    double dist = static_cast<double>(point_norm) + centroid_norms[j] -
+                  2 * DotProductAvx512(point, centroids + j * stride, n);
+    if (dist < lowest) {
+      lowest = dist;
+      nearest = static_cast<int>(j);
+    }
+  }
+
+  *distance = lowest;
+  return nearest;
+}
+
+#endif  // KERNELS_X86
+
+template <typename T>
+const BasicKernels<T> kScalarKernels = {
+    KernelIsa::SCALAR, "scalar", SquaredDistanceScalar<T>, DotProductScalar<T>,
+    NearestCentroidLoop<T, DotProductScalar<T>>};
+
+#if KERNELS_X86
+template <typename T>
+const BasicKernels<T> kSse2Kernels = {KernelIsa::SSE2, "sse2",
+                                      SquaredDistanceSse2, DotProductSse2,
+                                      NearestCentroidLoop<T, DotProductSse2>};
+
+template <typename T>
+const BasicKernels<T> kAvx2Kernels = {KernelIsa::AVX2, "avx2",
+                                      SquaredDistanceAvx2, DotProductAvx2,
+                                      NearestCentroidAvx2};
+
+template <typename T>
+const BasicKernels<T> kAvx512Kernels = {KernelIsa::AVX512, "avx512",
+                                        SquaredDistanceAvx512,
+                                        DotProductAvx512,
+                                        NearestCentroidAvx512};
+#endif
+
+template <typename T>
+const BasicKernels<T>* SelectBestKernels() {
+  for (int isa = static_cast<int>(KernelIsa::COUNT) - 1; isa >= 0; isa--) {
+    const BasicKernels<T>* kernels =
+        GetKernels<T>(static_cast<KernelIsa>(isa));
+    if (kernels != nullptr) return kernels;
+  }
+  return &kScalarKernels<T>;
+}
+
+}  // namespace
+
+template <typename T>
+const BasicKernels<T>* GetKernels(KernelIsa isa) {
+  switch (isa) {
+    case KernelIsa::SCALAR:
+      return &kScalarKernels<T>;
+#if KERNELS_X86
+    case KernelIsa::SSE2:
+      return __builtin_cpu_supports("sse2") ? &kSse2Kernels<T> : nullptr;
+    case KernelIsa::AVX2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")
+                 ? &kAvx2Kernels<T>
+                 : nullptr;
+    case KernelIsa::AVX512:
+      return __builtin_cpu_supports("avx512f") ? &kAvx512Kernels<T> : nullptr;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+template <typename T>
+const BasicKernels<T>& GetKernels() {
+  static const BasicKernels<T>* kernels = SelectBestKernels<T>();
+  return *kernels;
+}
+
+template const Kernels* GetKernels<double>(KernelIsa isa);
+template const FloatKernels* GetKernels<float>(KernelIsa isa);
+template const Kernels& GetKernels<double>();
+template const FloatKernels& GetKernels<float>();
@@ -0,0 +1,46 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef KERNELS_H_
+#define KERNELS_H_
+
+#include <cstddef>
+
+// Instruction sets a kernel table can be built for, ordered by preference
+enum class KernelIsa { SCALAR = 0, SSE2 = 1, AVX2 = 2, AVX512 = 3, COUNT };
+
+// Table of the hot distance loops for one instruction set and scalar type.
+// Every kernel takes a length n and handles any value of it, but callers
+// working on Matrix rows should pass Stride() so the zero padding lets the
+// vector loops run without a remainder. The arithmetic runs in T, results are
+// widened to double so callers accumulate in double either way.
+template <typename T>
+struct BasicKernels {
+  KernelIsa isa_;
+  const char* name_;
+
+  double (*squared_distance_)(const T* a, const T* b, size_t n);
+  double (*dot_product_)(const T* a, const T* b, size_t n);
+
+  // nearest of k centroids laid out stride values apart, using
+  // ||x||^2 + ||c||^2 - 2x.c, returns its index and writes its distance.
+  // Ties go to the lowest index.
+  int (*nearest_centroid_)(const T* point, T point_norm, const T* centroids,
+                           const T* centroid_norms, size_t k, size_t stride,
+                           size_t n, double* distance);
+};
+
+using Kernels = BasicKernels<double>;
+using FloatKernels = BasicKernels<float>;
+
+// best table the running CPU supports, selected once on first call
+template <typename T = double>
+const BasicKernels<T>& GetKernels();
+
+// table for a specific instruction set, nullptr when the CPU lacks it
+template <typename T = double>
+const BasicKernels<T>* GetKernels(KernelIsa isa);
+
+#endif  // KERNELS_H_
@@ -0,0 +1,38 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// Whole file mapped into memory with mmap. The mapping is private, writes
+// through MutableData() copy the touched pages and never reach the file.
+class MappedFile {
+ private:
+  char* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  MappedFile() = default;
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  // false when the file cannot be opened, is empty or cannot be mapped
+  bool Open(const std::string& path);
+  void Close();
+
+  bool IsOpen() const { return data_ != nullptr; }
+  const char* Data() const { return data_; }
+  char* MutableData() { return data_; }
+  size_t Size() const { return size_; }
+};
+
+#endif  // MAPPED_FILE_H_
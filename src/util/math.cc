@@ -9,39 +9,30 @@
 #include <vector>
 
 void CalculateCentroid(Cluster& cluster) {
-  size_t num_of_dimensions = cluster.points_[0].size();
-  size_t num_of_points = cluster.points_.size();
+  size_t num_of_dimensions = cluster.sum_.size();
 
   cluster.centroid_.resize(num_of_dimensions);
 
-  for (size_t i = 0; i < num_of_points; i++) {
-    for (size_t j = 0; j < num_of_dimensions; j++) {
-      cluster.centroid_[j] += cluster.points_[i][j];
-    }
-  }
-
+  // the norm is taken in the same pass so assignment never needs its own
+  double squared_norm = 0.0;
   for (size_t i = 0; i < num_of_dimensions; i++) {
-    cluster.centroid_[i] /= num_of_points;
+    double value = cluster.sum_[i] / cluster.num_of_points_;
+    cluster.centroid_[i] = value;
+    squared_norm += value * value;
   }
+  cluster.squared_norm_ = squared_norm;
 }
 
-double CalculateSSE(std::vector<Cluster> clusters) {
-  size_t num_of_clusters = clusters.size();
-
+double CalculateSSE(const Matrix& points, const std::vector<int>& labels,
+                    const std::vector<Cluster>& clusters) {
   double sse = 0.0;
-  for (size_t i = 0; i < num_of_clusters; i++) {
-    for (size_t j = 0; j < clusters[i].points_.size(); j++) {
-      sse += GetDistance(clusters[i].points_[j], clusters[i].centroid_);
-    }
+  for (size_t i = 0; i < points.Rows(); i++) {
+    sse += GetDistance(points[i], clusters[labels[i]].centroid_);
   }
 
   return sse;
 }
 
-double CalculateSquaredNorm(const std::vector<double>& point) {
-  double squared_norm = 0.0;
-  for (size_t i = 0; i < point.size(); i++) {
-    squared_norm += point[i] * point[i];
-  }
-  return squared_norm;
+double CalculateSquaredNorm(std::span<const double> point) {
+  return GetKernels().dot_product_(point.data(), point.data(), point.size());
 }
\ No newline at end of file
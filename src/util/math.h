@@ -7,28 +7,22 @@
 #define MATH_H_
 
 #include <iostream>
+#include <span>
 #include <vector>
 
 #include "../data/cluster.h"
+#include "../data/matrix.h"
+#include "./kernels.h"
 
-inline double GetDistance(const std::vector<double>& p1,
-                          const std::vector<double>& p2) {
+inline double GetDistance(std::span<const double> p1,
+                          std::span<const double> p2) {
   size_t size1 = p1.size();
   if (size1 != p2.size()) {
     std::cerr << "ERROR :: Points are of different dimensions." << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
-  const double* a = p1.data();
-  const double* b = p2.data();
-
-  double distance = 0;
-  for (size_t i = 0; i < size1; i++) {
-    const double diff = a[i] - b[i];
-    distance += diff * diff;
-  }
-
-  return distance;
+  return GetKernels().squared_distance_(p1.data(), p2.data(), size1);
 }
 
 inline double GetDistanceSquaredNorms(double squared_norm_p1,
@@ -37,10 +31,28 @@ inline double GetDistanceSquaredNorms(double squared_norm_p1,
   return squared_norm_p1 + squared_norm_p2 - 2 * dot_product;
 }
 
+inline void AddPointToCluster(Cluster& cluster, std::span<const double> point) {
+  for (size_t i = 0; i < point.size(); i++) {
+    cluster.sum_[i] += point[i];
+  }
+  cluster.num_of_points_++;
+}
+
+inline void RemovePointFromCluster(Cluster& cluster,
+                                   std::span<const double> point) {
+  for (size_t i = 0; i < point.size(); i++) {
+    cluster.sum_[i] -= point[i];
+  }
+  cluster.num_of_points_--;
+}
+
+// centroid = sum of members / number of members, also refreshes the
+// centroid's squared norm
 void CalculateCentroid(Cluster& cluster);
 
-double CalculateSSE(std::vector<Cluster> clusters);
+double CalculateSSE(const Matrix& points, const std::vector<int>& labels,
+                    const std::vector<Cluster>& clusters);
 
-double CalculateSquaredNorm(const std::vector<double>& point);
+double CalculateSquaredNorm(std::span<const double> point);
 
 #endif  // MATH_H_
@@ -0,0 +1,113 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./thread_pool.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+ThreadPool::ThreadPool(int num_of_threads) {
+  if (num_of_threads <= 0) {
+    num_of_threads =
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+
+  for (int i = 0; i < num_of_threads; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  condition_.notify_all();
+
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_[i].join();
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    size_t block = 0;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] {
+        return stop_ || !tasks_.empty() || next_block_ < num_of_blocks_;
+      });
+
+      // blocks of a ParallelFor go first, its caller is waiting on them
+      if (next_block_ < num_of_blocks_) {
+        block = next_block_++;
+      } else {
+        if (stop_ && tasks_.empty()) return;
+        task = std::move(tasks_.front());
+        tasks_.pop();
+      }
+    }
+
+    if (task) {
+      task();
+    } else {
+      RunBlock(block);
+    }
+  }
+}
+
+void ThreadPool::RunBlock(size_t block) {
+  size_t begin = std::min(range_n_, block * range_block_size_);
+  size_t end = std::min(range_n_, begin + range_block_size_);
+  (*range_fn_)(begin, end, static_cast<int>(block));
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (--blocks_left_ == 0) range_done_.notify_one();
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task) {
+  auto packaged =
+      std::make_shared<std::packaged_task<void()>>(std::move(task));
+  std::future<void> result = packaged->get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.emplace([packaged] { (*packaged)(); });
+  }
+  condition_.notify_one();
+  return result;
+}
+
+void ThreadPool::ParallelFor(
+    size_t n, const std::function<void(size_t, size_t, int)>& fn) {
+  // every worker index gets a call, possibly with an empty range, so callers
+  // can rely on per-worker state being refreshed
+  size_t num_of_blocks = static_cast<size_t>(GetNumOfThreads());
+  size_t block_size = (n + num_of_blocks - 1) / num_of_blocks;
+  if (num_of_blocks == 1) {
+    fn(0, n, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> one_at_a_time(range_mutex_);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    range_fn_ = &fn;
+    range_n_ = n;
+    range_block_size_ = block_size;
+    next_block_ = 1;
+    num_of_blocks_ = num_of_blocks;
+    blocks_left_ = num_of_blocks - 1;
+  }
+  condition_.notify_all();
+
+  fn(0, std::min(n, block_size), 0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  range_done_.wait(lock, [this] { return blocks_left_ == 0; });
+  range_fn_ = nullptr;
+  next_block_ = num_of_blocks_ = 0;
+}
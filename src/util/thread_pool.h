@@ -0,0 +1,65 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads fed from a single FIFO queue.
+// ParallelFor hands its blocks to the workers through a single slot instead
+// of the queue, so it allocates nothing and can sit in an iteration loop.
+// It must not be called from inside a task of the same pool, the calling
+// worker would wait on blocks that can never be scheduled.
+class ThreadPool {
+ private:
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_ = false;
+
+  // the ParallelFor in flight, workers take blocks [1, num_of_blocks_) in
+  // turn and the caller waits on range_done_ for blocks_left_ to reach 0.
+  // Guarded by mutex_, range_mutex_ lets one ParallelFor run at a time.
+  const std::function<void(size_t, size_t, int)>* range_fn_ = nullptr;
+  size_t range_n_ = 0;
+  size_t range_block_size_ = 0;
+  size_t next_block_ = 0;
+  size_t num_of_blocks_ = 0;
+  size_t blocks_left_ = 0;
+  std::condition_variable range_done_;
+  std::mutex range_mutex_;
+
+  void WorkerLoop();
+  void RunBlock(size_t block);
+
+ public:
+  // 0 threads means one per hardware thread
+  explicit ThreadPool(int num_of_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int GetNumOfThreads() const { return static_cast<int>(workers_.size()); }
+
+  std::future<void> Submit(std::function<void()> task);
+
+  // splits [0, n) into one contiguous block per thread and calls
+  // fn(begin, end, block_index) for each, the caller runs block 0 itself and
+  // returns once every block is done
+  void ParallelFor(size_t n,
+                   const std::function<void(size_t, size_t, int)>& fn);
+};
+
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,68 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#include "./work_stealing_pool.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+WorkStealingPool::WorkStealingPool(int num_of_threads) {
+  if (num_of_threads <= 0) {
+    num_of_threads =
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+  num_of_threads_ = num_of_threads;
+}
+
+bool WorkStealingPool::PopOwn(WorkQueue& queue, std::function<void()>& task) {
+  std::lock_guard<std::mutex> lock(queue.mutex_);
+  if (queue.tasks_.empty()) return false;
+  task = std::move(queue.tasks_.front());
+  queue.tasks_.pop_front();
+  return true;
+}
+
+bool WorkStealingPool::Steal(std::vector<WorkQueue>& queues, size_t thief,
+                             std::function<void()>& task) {
+  // start with the next thread over so thieves spread across victims
+  for (size_t offset = 1; offset < queues.size(); offset++) {
+    WorkQueue& victim = queues[(thief + offset) % queues.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex_);
+    if (victim.tasks_.empty()) continue;
+    task = std::move(victim.tasks_.back());
+    victim.tasks_.pop_back();
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::Run(std::vector<std::function<void()>> tasks) {
+  size_t num_of_workers =
+      std::min(static_cast<size_t>(num_of_threads_), tasks.size());
+  if (num_of_workers == 0) return;
+
+  std::vector<WorkQueue> queues(num_of_workers);
+  for (size_t t = 0; t < tasks.size(); t++) {
+    queues[t % num_of_workers].tasks_.push_back(std::move(tasks[t]));
+  }
+
+  // no task adds work, so a thread that finds every deque empty is done
+  auto work = [this, &queues](size_t worker) {
+    std::function<void()> task;
+    while (PopOwn(queues[worker], task) || Steal(queues, worker, task)) {
+      task();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t w = 1; w < num_of_workers; w++) {
+    threads.emplace_back(work, w);
+  }
+  work(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
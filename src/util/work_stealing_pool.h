@@ -0,0 +1,46 @@
+// Author: Jackson Rudnick
+// Coding Style Standards
+// https://google.github.io/styleguide/cppguide.html
+// Copyright 2025 Jackson Rudnick
+
+#ifndef WORK_STEALING_POOL_H_
+#define WORK_STEALING_POOL_H_
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Runs a batch of independent, coarse tasks (whole clustering jobs) to
+// completion. Tasks are dealt round robin to one deque per thread in the
+// order given, so passing them longest first starts the longest jobs first.
+// A thread works through its own deque from the front and, once that is
+// empty, steals from the back of the others, which holds their shortest
+// remaining jobs. Unlike ThreadPool nothing is shared between tasks, so a
+// long job never waits behind short ones queued on the same thread.
+class WorkStealingPool {
+ private:
+  struct WorkQueue {
+    std::mutex mutex_;
+    std::deque<std::function<void()>> tasks_;
+  };
+
+  int num_of_threads_;
+
+  bool PopOwn(WorkQueue& queue, std::function<void()>& task);
+  bool Steal(std::vector<WorkQueue>& queues, size_t thief,
+             std::function<void()>& task);
+
+ public:
+  // 0 threads means one per hardware thread
+  explicit WorkStealingPool(int num_of_threads = 0);
+
+  int GetNumOfThreads() const { return num_of_threads_; }
+
+  // runs every task and returns once all of them are done, the calling
+  // thread takes part as one of the workers
+  void Run(std::vector<std::function<void()>> tasks);
+};
+
+#endif  // WORK_STEALING_POOL_H_
@@ -6,7 +6,6 @@
 #include <filesystem>
 #include <fstream>
 
-#include "../algo/k_means.h"
 #include "../data/data.h"
 #include "../util/config.h"
 #include "../util/util.h"
@@ -32,15 +31,12 @@ int main() {
 
   std::vector<Data*> data = ReadDatasets();
 
-  K_Means* k_means;
-  Validate* validate;
-
   for (size_t i = 0; i < data.size(); i++) {
-    k_means = new K_Means(data[i]);
-    validate = new Validate(data[i]);
+    Validate validate(data[i]);
+    validate.SetPrecision(CLUSTERING_PRECISION);
 
     // Run validation
-    validate->RunValidation();
+    validate.RunValidation();
   }
 
   // Restore original cout buffer
@@ -49,9 +45,6 @@ int main() {
   output_stream.close();
 
   // Clean up
-  delete k_means;
-  delete validate;
-
   for (size_t i = 0; i < data.size(); i++) {
     delete data[i];
   }
@@ -5,114 +5,151 @@
 
 #include "./validate.h"
 
-double Validate::SilhouetteWidth() {
-  std::vector<std::vector<double>> points = data_->GetPoints();
-  std::vector<Cluster> clusters = k_means_->GetBestClusters();
-
-  std::vector<double> cohesion_scores;
-  std::vector<double> separation_scores;
-
-  std::vector<double> silhouette_scores;
-
-  // Calculate cohesion - average distance to each point in the same cluster for
-  // each point
-  cohesion_scores.reserve(points.size());
-
-  for (size_t i = 0; i < clusters.size(); i++) {
-    size_t cluster_size = clusters[i].points_.size();
-    if (cluster_size == 0) continue;
-
-    for (size_t j = 0; j < cluster_size; ++j) {
-      if (cluster_size == 1) {
-        cohesion_scores.push_back(0.0);
-        continue;
-      }
-
-      double sum = 0.0;
-      for (size_t k = 0; k < cluster_size; k++) {
-        if (j == k) continue;
-        sum += GetDistance(clusters[i].points_[j], clusters[i].points_[k]);
-      }
-      cohesion_scores.push_back(sum / static_cast<double>(cluster_size - 1));
-    }
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "../util/blocked_assign.h"
+
+// Silhouette tiles: a block of kSilhouetteRows points is scored against
+// kSilhouetteCols points at a time, so the column block stays in cache while
+// every row of the block passes over it
+constexpr size_t kSilhouetteRows = 32;
+constexpr size_t kSilhouetteCols = 256;
+static_assert(kSilhouetteCols % kCentroidPanelWidth == 0,
+              "a column tile must be whole packed panels");
+
+// Exact silhouette over all n^2 pairs. One sweep over the columns adds each
+// pair's distance into the row point's sum for the column point's cluster,
+// which gives both a(i) (own cluster) and b(i) (lowest average over every
+// other cluster) without a second pass. The points are packed into panels
+// once, the way the blocked assignment packs centroids, so every tile of
+// distances comes out of the same register blocked micro-kernel and each
+// column load is reused by four rows. Rows are split across the pool, every
+// row is independent so no worker writes to another's sums.
+double Validate::SilhouetteWidth(K_Means& k_means, ThreadPool* pool) {
+  const Matrix& points = data_->GetPoints();
+  const std::vector<double>& norms = data_->GetSquaredNorms();
+  const std::vector<int>& labels = k_means.GetBestLabels();
+  size_t num_of_points = points.Rows();
+  size_t num_of_clusters = k_means.GetBestClusters().size();
+  size_t stride = points.Stride();
+
+  std::vector<size_t> cluster_sizes(num_of_clusters, 0);
+  for (size_t i = 0; i < num_of_points; i++) {
+    cluster_sizes[labels[i]]++;
   }
 
-  // Calculate separation - average distance to each point in the nearest
-  // cluster
-  separation_scores.reserve(points.size());
-
-  for (size_t i = 0; i < clusters.size(); i++) {
-    size_t cluster1_size = clusters[i].points_.size();
-    if (cluster1_size == 0) continue;
-
-    double cluster_min_dist = std::numeric_limits<double>::max();
-    size_t cluster_min_dist_id = clusters.size();
-
-    for (size_t j = 0; j < clusters.size(); j++) {
-      if (i == j) continue;
-      if (clusters[j].points_.empty()) continue;  // skip empty clusters
-
-      double dist = GetDistance(clusters[i].centroid_, clusters[j].centroid_);
-      if (dist < cluster_min_dist) {
-        cluster_min_dist = dist;
-        cluster_min_dist_id = j;
+  PackedCentroids packed_points;
+  PackCentroids(points, norms.data(), packed_points);
+
+  std::vector<double> partial_scores(
+      pool != nullptr ? pool->GetNumOfThreads() : 1, 0.0);
+
+  auto score_range = [&](size_t begin, size_t end, int worker) {
+    // distance sums of kSilhouetteRows points to every cluster, and one tile
+    // of their squared distances
+    std::vector<double> sums(kSilhouetteRows * num_of_clusters);
+    std::vector<double> tile(kSilhouetteRows * kSilhouetteCols);
+    double score = 0.0;
+
+    for (size_t row_block = begin; row_block < end;
+         row_block += kSilhouetteRows) {
+      size_t rows = std::min(kSilhouetteRows, end - row_block);
+      std::fill(sums.begin(), sums.end(), 0.0);
+
+      for (size_t col_block = 0; col_block < num_of_points;
+           col_block += kSilhouetteCols) {
+        size_t col_end = std::min(col_block + kSilhouetteCols, num_of_points);
+        size_t cols = col_end - col_block;
+        BlockSquaredDistances(
+            points.Row(row_block), stride, &norms[row_block], rows,
+            packed_points, col_block / kCentroidPanelWidth,
+            (cols + kCentroidPanelWidth - 1) / kCentroidPanelWidth,
+            tile.data(), kSilhouetteCols);
+
+        for (size_t r = 0; r < rows; r++) {
+          size_t i = row_block + r;
+          const double* distances = &tile[r * kSilhouetteCols];
+          double* row_sums = &sums[r * num_of_clusters];
+
+          for (size_t c = 0; c < cols; c++) {
+            size_t j = col_block + c;
+            if (j == i) continue;
+            // the norm expansion can round slightly below zero for
+            // duplicate points
+            row_sums[labels[j]] += std::sqrt(std::max(distances[c], 0.0));
+          }
+        }
       }
-    }
 
-    size_t c2 = cluster_min_dist_id;
-    size_t cluster2_size = clusters[c2].points_.size();
-
-    for (size_t j = 0; j < cluster1_size; j++) {
-      double sum = 0.0;
-      for (size_t k = 0; k < cluster2_size; k++) {
-        sum += GetDistance(clusters[i].points_[j], clusters[c2].points_[k]);
+      for (size_t r = 0; r < rows; r++) {
+        size_t i = row_block + r;
+        size_t own = labels[i];
+        // a point alone in its cluster scores 0 by definition
+        if (cluster_sizes[own] <= 1) continue;
+
+        const double* row_sums = &sums[r * num_of_clusters];
+        double cohesion =
+            row_sums[own] / static_cast<double>(cluster_sizes[own] - 1);
+
+        double separation = std::numeric_limits<double>::max();
+        for (size_t c = 0; c < num_of_clusters; c++) {
+          if (c == own || cluster_sizes[c] == 0) continue;
+          separation = std::min(
+              separation, row_sums[c] / static_cast<double>(cluster_sizes[c]));
+        }
+        if (separation == std::numeric_limits<double>::max()) continue;
+
+        double largest = std::max(separation, cohesion);
+        if (largest > 0.0) score += (separation - cohesion) / largest;
       }
-      // Average separation per point
-      separation_scores.push_back(sum / static_cast<double>(cluster2_size));
     }
+    partial_scores[worker] = score;
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(num_of_points, score_range);
+  } else {
+    score_range(0, num_of_points, 0);
   }
 
-  // Silhouette = (separation - cohesion) / max(separation, cohesion)
-  silhouette_scores.reserve(points.size());
-  for (size_t i = 0; i < cohesion_scores.size(); i++) {
-    double val = (separation_scores[i] - cohesion_scores[i]) /
-                 std::max(separation_scores[i], cohesion_scores[i]);
-
-    silhouette_scores.push_back(val);
-  }
-
-  // Average silhouette over all points
+  // reduced in worker order so the result only depends on the thread count
   double score = 0.0;
-  for (size_t i = 0; i < silhouette_scores.size(); i++) {
-    score += silhouette_scores[i];
+  for (double partial : partial_scores) {
+    score += partial;
   }
-  score /= points.size();
-
-  return score;
+  return score / static_cast<double>(num_of_points);
 }
 
-double Validate::CalinskiHarabasz() {
+double Validate::CalinskiHarabasz(K_Means& k_means) {
   // BCSS (Between-Cluster Sum of Squares) is the weighted sum of squared
   // Euclidean distances between each cluster centroid (mean) and the overall
   // data centroid (mean)
 
   // get overall data centroid
-  std::vector<std::vector<double>> points = data_->GetPoints();
-  std::vector<double> overall_centroid(points[0].size(), 0.0);
-  for (size_t i = 0; i < points.size(); i++) {
-    for (size_t j = 0; j < points[0].size(); j++) {
-      overall_centroid[j] += points[i][j];
+  const Matrix& points = data_->GetPoints();
+  std::vector<double> overall_centroid(points.Cols(), 0.0);
+  for (size_t i = 0; i < points.Rows(); i++) {
+    const double* point = points.Row(i);
+    for (size_t j = 0; j < points.Cols(); j++) {
+      overall_centroid[j] += point[j];
     }
   }
-  for (size_t j = 0; j < points[0].size(); j++) {
-    overall_centroid[j] /= static_cast<double>(points.size());
+  for (size_t j = 0; j < points.Cols(); j++) {
+    overall_centroid[j] /= static_cast<double>(points.Rows());
   }
 
-  // calculate BCSS
-  std::vector<Cluster> clusters = k_means_->GetClusters();
+  // calculate BCSS, over the same best run the silhouette width scores
+  const std::vector<Cluster>& clusters = k_means.GetBestClusters();
+  const std::vector<int>& labels = k_means.GetBestLabels();
   double bcss = 0.0;
   for (size_t i = 0; i < clusters.size(); i++) {
-    size_t cluster_size = clusters[i].points_.size();
+    size_t cluster_size = clusters[i].num_of_points_;
     if (cluster_size == 0) continue;
     double dist = GetDistance(clusters[i].centroid_, overall_centroid);
     bcss += static_cast<double>(cluster_size) * dist;
@@ -120,57 +157,141 @@ double Validate::CalinskiHarabasz() {
 
   // WCSS (Within-Cluster Sum of Squares) is the sum of squared Euclidean
   // distances between the data points and their respective cluster centroids
-  double wcss = 0.0;
-  for (size_t i = 0; i < clusters.size(); i++) {
-    size_t cluster_size = clusters[i].points_.size();
-    if (cluster_size == 0) continue;
-
-    for (size_t j = 0; j < cluster_size; j++) {
-      double dist = GetDistance(clusters[i].points_[j], clusters[i].centroid_);
-      wcss += dist;
-    }
-  }
+  double wcss = CalculateSSE(points, labels, clusters);
 
   double index = (bcss * (clusters.size() - 1)) /
-                 (wcss * (points.size() - clusters.size()));
+                 (wcss * (points.Rows() - clusters.size()));
 
   return index;
 }
 
-void Validate::PrintScores(size_t k, double score) {
+void Validate::PrintScores(size_t k, ValidationMethod method, double score) {
   std::cout << data_->GetFileName() << ",";
 
-  if (method_ == ValidationMethod::SILHOUETTE_WIDTH) {
+  if (method == ValidationMethod::SILHOUETTE_WIDTH) {
     std::cout << "Silhouette Width,";
-  } else if (method_ == ValidationMethod::CALINSKI_HARABASZ) {
+  } else if (method == ValidationMethod::CALINSKI_HARABASZ) {
     std::cout << "Calinski Harabasz,";
   }
 
   std::cout << k << "," << score << std::endl;
 }
 
-void Validate::RunValidation() {
-  min_clusters = 65;
+// starts next from previous's best clustering with the cluster of highest
+// SSE split in two: every restart keeps the k-1 centroids and draws the new
+// one from that cluster's points, weighted by their squared distance to its
+// centroid, so far points are the likely picks and the restarts still differ
+void Validate::WarmStart(K_Means& previous, K_Means& next) {
+  const Matrix& points = data_->GetPoints();
+  const std::vector<Cluster>& clusters = previous.GetBestClusters();
+  const std::vector<int>& labels = previous.GetBestLabels();
+  size_t num_of_clusters = clusters.size();
+
+  std::vector<double> distances(points.Rows());
+  std::vector<double> cluster_sse(num_of_clusters, 0.0);
+  for (size_t i = 0; i < points.Rows(); i++) {
+    int c = labels[i];
+    distances[i] = GetDistance(points[i], clusters[c].centroid_);
+    cluster_sse[c] += distances[i];
+  }
 
-  for (size_t k = min_clusters; k <= max_clusters; k++) {
-    data_->SetNumOfClusters(static_cast<int>(k));
+  int worst = static_cast<int>(
+      std::max_element(cluster_sse.begin(), cluster_sse.end()) -
+      cluster_sse.begin());
 
-    k_means_ = new K_Means(data_);
-    k_means_->Run();
+  std::vector<int> split_points;
+  std::vector<double> split_weights;
+  for (size_t i = 0; i < points.Rows(); i++) {
+    if (labels[i] != worst) continue;
+    split_points.push_back(static_cast<int>(i));
+    split_weights.push_back(distances[i]);
+  }
+  // every member sits on the centroid, any of them is as good
+  if (cluster_sse[worst] == 0.0) {
+    split_weights.assign(split_weights.size(), 1.0);
+  }
 
-    double score = SilhouetteWidth();
+  Matrix centroids(num_of_clusters, points.Cols());
+  for (size_t c = 0; c < num_of_clusters; c++) {
+    std::copy(clusters[c].centroid_.begin(), clusters[c].centroid_.end(),
+              centroids.Row(c));
+  }
+  next.SetInitialCentroids(centroids, std::move(split_points),
+                           std::move(split_weights));
+}
 
-    method_ = ValidationMethod::SILHOUETTE_WIDTH;
-    PrintScores(k, score);
+// one chain of consecutive k, the first cold started and each later one warm
+// started from the previous k, all with every restart
+void Validate::RunChain(size_t first_k, size_t last_k) {
+  std::unique_ptr<K_Means> previous;
+
+  for (size_t k = first_k; k <= last_k; k++) {
+    // this worker already is one of the sweep's threads, the run and the
+    // scores stay on it
+    auto k_means = std::make_unique<K_Means>(
+        data_, InitializationMethod::RANDOM_PARTITION, 1);
+    k_means->SetNumOfClusters(static_cast<int>(k));
+    k_means->SetAlgorithm(SweepAlgorithm(k));
+    k_means->SetPrecision(precision_);
+    if (previous != nullptr) WarmStart(*previous, *k_means);
+    k_means->Run();
+
+    double silhouette = SilhouetteWidth(*k_means, nullptr);
+    double calinski_harabasz = CalinskiHarabasz(*k_means);
+
+    // streamed as soon as this k is done, rows of concurrent chains
+    // interleave
+    {
+      std::lock_guard<std::mutex> lock(output_mutex_);
+      PrintScores(k, ValidationMethod::SILHOUETTE_WIDTH, silhouette);
+      PrintScores(k, ValidationMethod::CALINSKI_HARABASZ, calinski_harabasz);
+    }
+
+    previous = std::move(k_means);
+  }
+}
+
+void Validate::RunValidation() {
+  if (max_clusters < min_clusters) return;
+
+  size_t num_of_k = max_clusters - min_clusters + 1;
+  size_t chain_length = warm_start_ ? VALIDATION_CHAIN_LENGTH : 1;
+  size_t num_of_chains = (num_of_k + chain_length - 1) / chain_length;
+
+  // chains are handed out in order to whichever thread is free
+  std::atomic<size_t> next_chain{0};
+  thread_pool_->ParallelFor(
+      thread_pool_->GetNumOfThreads(),
+      [&](size_t /*begin*/, size_t /*end*/, int /*worker*/) {
+        for (size_t chain = next_chain++; chain < num_of_chains;
+             chain = next_chain++) {
+          size_t first_k = min_clusters + chain * chain_length;
+          RunChain(first_k, std::min(first_k + chain_length - 1, max_clusters));
+        }
+      });
+}
+
+Algorithm Validate::SweepAlgorithm(size_t k) {
+  if (algorithm_fixed_) return algorithm_;
 
-    score = CalinskiHarabasz();
+  // the filtering and bounds algorithms below keep double, only the Lloyd
+  // assignment reads the float copy
+  if (precision_ == Precision::FLOAT32) return Algorithm::LLOYD;
 
-    method_ = ValidationMethod::CALINSKI_HARABASZ;
-    PrintScores(k, score);
+  // every k of the sweep then walks the one KD-tree data_ holds
+  if (data_->GetNumOfDimensions() <= FILTERING_MAX_DIMENSIONS &&
+      data_->GetNumOfPoints() >= FILTERING_MIN_POINTS) {
+    return Algorithm::FILTERING;
   }
+
+  // below BALL_TREE_MIN_K the ball tree would assign like LLOYD, Yinyang's
+  // group bounds skip most of those distances instead
+  if (k < BALL_TREE_MIN_K) return Algorithm::YINYANG;
+  return Algorithm::BALL_TREE;
 }
 
-Validate::Validate(Data* data) : data_(data) {
+Validate::Validate(Data* data, int num_of_threads) : data_(data) {
+  thread_pool_ = std::make_unique<ThreadPool>(num_of_threads);
   max_clusters = static_cast<size_t>(
       round(sqrt(static_cast<double>(data_->GetNumOfPoints()) / 2.0)));
-}
\ No newline at end of file
+}
@@ -6,28 +6,63 @@
 #ifndef VALIDATE_H_
 #define VALIDATE_H_
 
+#include <memory>
+#include <mutex>
+
 #include "../algo/k_means.h"
 #include "../data/data.h"
 #include "../util/config.h"
 #include "../util/math.h"
+#include "../util/thread_pool.h"
 
+// Sweeps k from K_MIN to sqrt(n / 2) and prints the silhouette width and
+// Calinski-Harabasz index of each k. The range is cut into chains of
+// VALIDATION_CHAIN_LENGTH consecutive k that run concurrently on the pool;
+// within a chain every k after the first is warm started from the previous
+// k's best clustering with its highest SSE cluster split in two. Every k runs
+// all of the dataset's restarts, a warm started one draws its split point
+// anew for each.
 class Validate {
  private:
-  ValidationMethod method_;
   Data* data_;
-  K_Means* k_means_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  std::mutex output_mutex_;
+  bool warm_start_ = VALIDATION_WARM_START;
+  // set by SetAlgorithm, otherwise SweepAlgorithm picks one per k
+  bool algorithm_fixed_ = false;
+  Algorithm algorithm_ = Algorithm::LLOYD;
+  Precision precision_ = Precision::FLOAT64;
 
   size_t min_clusters = K_MIN;
   size_t max_clusters;
 
-  double SilhouetteWidth();
-  double CalinskiHarabasz();
-  void PrintScores(size_t k, double score);
+  void PrintScores(size_t k, ValidationMethod method, double score);
+  Algorithm SweepAlgorithm(size_t k);
+  void WarmStart(K_Means& previous, K_Means& next);
+  void RunChain(size_t first_k, size_t last_k);
 
  public:
-  Validate(Data* data);
+  explicit Validate(Data* data, int num_of_threads = NUM_OF_THREADS);
+
+  // scores of k_means's best run, pool may be nullptr to score on the calling
+  // thread
+  double SilhouetteWidth(K_Means& k_means, ThreadPool* pool);
+  double CalinskiHarabasz(K_Means& k_means);
+
+  // false runs every k from scratch with all of its restarts
+  void SetWarmStart(bool warm_start) { warm_start_ = warm_start; }
+  // defaults to FILTERING for low dimensional data with many points, and
+  // otherwise to YINYANG below BALL_TREE_MIN_K clusters and BALL_TREE from
+  // there on
+  void SetAlgorithm(Algorithm algorithm) {
+    algorithm_ = algorithm;
+    algorithm_fixed_ = true;
+  }
+  // only the Lloyd assignment reads single precision, see K_Means, so
+  // FLOAT32 sweeps every k with LLOYD unless SetAlgorithm fixed another
+  void SetPrecision(Precision precision) { precision_ = precision; }
 
   void RunValidation();
 };
 
-#endif  // VALIDATE_H_
\ No newline at end of file
+#endif  // VALIDATE_H_